@@ -37,6 +37,7 @@
     SOFTWARE.
 */
 
+#include <string.h>
 #include "mcc_generated_files/mcc.h"
 #include "mcc_generated_files/application/LIGHTBLUE_service.h"
 #include "mcc_generated_files/rn487x/rn487x_interface.h"
@@ -60,16 +61,25 @@
  *  This is used by the application for communication buffers.
  */
 #define MAX_BUFFER_SIZE                 (80)
+/** MACRO used to define the CDC terminal line printing the UART link statistics.
+ *  The line is handled locally instead of being sent to Light Blue.
+ */
+#define LINK_STATS_COMMAND              "#stats"
+/** MACRO used to configure the CDC receive idle gap, in character times.
+ *  A CDC line left without CR or LF is sent once the terminal was quiet
+ *  this long, about 0.25 s at 9600 baud.
+ */
+#define CDC_IDLE_CHARACTERS             (240)
 
 static char statusBuffer[MAX_BUFFER_SIZE];      /**< Status Buffer instance passed to RN487X drive used for Asynchronous Message Handling (see *asyncBuffer in rn487x.c) */
-static char lightBlueSerial[MAX_BUFFER_SIZE];   /**< Message Buffer used for CDC Serial communication when connected. Terminated by \r, \n, MAX character Passes messages to BLE for transmisison. */
-static uint8_t serialIndex;                     /**< Local index value for serial communication buffer. */
 
 /*
                          Main application
  */
 int main(void)
 {
+    const char *serialLine;
+
     // initialize the device
     SYSTEM_Initialize();
     RN487X_SetAsyncMessageHandler(statusBuffer, sizeof(statusBuffer));
@@ -81,16 +91,42 @@ int main(void)
     INTERRUPT_PeripheralInterruptEnable();
 
     RN487X_Init();
+#if BLE_UART_BAUD_NEGOTIATION
+    RN487X_NegotiateBaudRate(BLE_UART_TARGET_BAUD, BLE_UART_BOOT_BAUD);
+#endif
+#if BLE_UART_FLOW_CONTROL
+    if (RN487X_SetFlowControl(true) == true)
+    {
+        EUSART2_SetFlowControl(true);
+    }
+#endif
     LIGHTBLUE_Initialize();
+    EUSART1_SetIdleCharacters(CDC_IDLE_CHARACTERS);
 
     while (1)
     {
-        if (RN487X_IsConnected() == true)
+        I2C1_Tasks();
+        if (RN487X_IsCmdPending() == true)
         {
+            RN487X_SetBridgeMode(false);
+            // RN487X is in command mode; its responses are consumed by the command queue,
+            // only data received before the commands is still returned
+            while (RN487X_DataReady())
+            {
+                LIGHTBLUE_ParseIncomingPacket(RN487X_Read());
+            }
+        }
+        else if (RN487X_IsConnected() == true)
+        {
+            // CDC lines are assembled by the EUSART1 receive interrupt
+            RN487X_SetBridgeMode(false);
+            EUSART1_SetLineMode(true);
+            LIGHTBLUE_SensorTasks();
             if (TIMER_FLAG_SET() == true)
             {
                 RESET_TIMER_INTERRUPT_FLAG;
 
+                LIGHTBLUE_StartTelemetryFrame();
                 LIGHTBLUE_TemperatureSensor();
                 LIGHTBLUE_AccelSensor();
                 LIGHTBLUE_PushButton();
@@ -103,35 +139,36 @@ int main(void)
                 {
                     LIGHTBLUE_ParseIncomingPacket(RN487X_Read());
                 }
-                while (uart[UART_CDC].DataReady())
+                serialLine = EUSART1_GetLine();
+                if (serialLine != NULL)
                 {
-                    lightBlueSerial[serialIndex] = uart[UART_CDC].Read();
-                    if ((lightBlueSerial[serialIndex] == '\r')
-                        || (lightBlueSerial[serialIndex] == '\n')
-                        || (serialIndex == (sizeof(lightBlueSerial) - 1)))
+                    if (strcmp(serialLine, LINK_STATS_COMMAND) == 0)
                     {
-                        lightBlueSerial[serialIndex] = '\0';
-                        LIGHTBLUE_SendSerialData(lightBlueSerial);
-                        serialIndex = 0;
+                        LIGHTBLUE_PrintLinkStats();
                     }
                     else
                     {
-                        serialIndex++;
+                        LIGHTBLUE_SendSerialData(serialLine);
                     }
+                    EUSART1_ReleaseLine();
                 }
-                
             }
         }
         else
         {
-            while(RN487X_DataReady())
-            {
-                uart[UART_CDC].Write(RN487X_Read());
-            }
-            while (uart[UART_CDC].DataReady())
+            LIGHTBLUE_ResetSession();
+            EUSART1_SetLineMode(false);
+#if BLE_PRIVATE_SERVICE
+            // RN487X is held in command mode, only its status messages are handled
+            while (RN487X_DataReady())
             {
-                RN487X.Write(uart[UART_CDC].Read());
+                RN487X_Read();
             }
+#else
+            // CDC <-> BLE data is forwarded by the UART interrupts
+            RN487X_SetBridgeMode(true);
+            RN487X_BridgeTasks();
+#endif
         }
     }
     return 0;
@@ -26,120 +26,160 @@
 
 #include "BMA253_accel.h"
 #include "../drivers/i2c_simple_master.h"
+#include "../pin_manager.h"
 
 /**
 \ingroup BMA253
-\def DATA_READY_BIT_MASK
-This is a macro is used as a mask to filter only the Data Ready bit (bit 0)
-status result when confirming a data registers data is new/ready to read. 
+\def ACCEL_DATA_BLOCK_SIZE
+This is a macro for the number of data registers (X LSB -> Z MSB) captured by
+a single auto-incrementing burst read.
 */
-#define DATA_READY_BIT_MASK                 (0x01)
+#define ACCEL_DATA_BLOCK_SIZE               (BMA253_Z_MSB_ADDR - BMA253_X_LSB_ADDR + 1)
+/**
+\ingroup BMA253
+\def AXIS_DATA_BLOCK_SIZE
+This is a macro for the number of data registers (LSB, MSB) used by a single axis.
+*/
+#define AXIS_DATA_BLOCK_SIZE                (2)
+/**
+ \ingroup BMA253
+ \brief \n
+ * This API function is used private within the source file to read the LSB and
+ MSB registers of a single axis in one burst read.
+ \param[in] lsbAddress - register address of the axis LSB data register \n
+ \return Signed 12-bit acceleration value of the requested axis \n
+ */
+static int16_t BMA253_ReadAxis(uint8_t lsbAddress);
 /**
  \ingroup BMA253
  \brief \n
- * This API function is used private within the source file to confirm data is
- ready to be read prior to converting and return the data value stored representing
- the X-Axis Acceleration
- \return Status of the registers Ready State, indicating new data ready to be read \n 
- \retval bool true | false representation of bit 0 in register value \n
+ * This API function is used private within the source file to convert the
+ LSB/MSB register pair of an axis into the signed 12-bit acceleration value.
+ \param[in] axisData - pointer to the (2) byte LSB/MSB register pair \n
+ \return Signed 12-bit acceleration value \n
  */
-static bool BMA253_NewAccelDataRdyX(void);
+static int16_t BMA253_DecodeAxis(const uint8_t *axisData);
 /**
  \ingroup BMA253
  \brief \n
- * This API function is used private within the source file to confirm data is
- ready to be read prior to converting and return the data value stored representing
- the Y-Axis Acceleration
- \return Status of the registers Ready State, indicating new data ready to be read \n 
- \retval bool true | false representation of bit 0 in register value \n
+ * This API function is used private within the source file to convert a block
+ of X, Y, Z LSB/MSB register pairs (data registers or FIFO frames) into frames.
+ \param[in] block - pointer to the (6) byte blocks \n
+ \param[in] frames - frames receiving the decoded values \n
+ \param[in] count - number of frames to decode \n
+ \return void \n
  */
-static bool BMA253_NewAccelDataRdyY(void);
+static void BMA253_DecodeFrames(const uint8_t *block, BMA253_ACCEL_DATA_t *frames, uint8_t count);
 /**
  \ingroup BMA253
  \brief \n
- * This API function is used private within the source file to confirm data is
- ready to be read prior to converting and return the data value stored representing
- the Z-Axis Acceleration
- \return Status of the registers Ready State, indicating new data ready to be read \n 
- \retval bool true | false representation of bit 0 in register value \n
+ * This API function is used private within the source file. It is called from
+ I2C1_Tasks() when the interrupt driven burst read has finished.
+ \param[in] error - bus status of the finished transaction \n
+ \param[in] ptr - unused \n
+ \return void \n
  */
-static bool BMA253_NewAccelDataRdyZ(void);
+static void BMA253_AccelDataReadComplete(i2c1_error_t error, void *ptr);
+/**
+ \ingroup BMA253
+ \brief \n
+ * This API function is used private within the source file. It queues the FIFO
+ Status and FIFO Data reads as one batch, unless the frames of the previous read
+ have not been taken yet.
+ \return void \n
+ */
+static void BMA253_StartFifoRead(void);
+/**
+ \ingroup BMA253
+ \brief \n
+ * This API function is used private within the source file. It is called from
+ I2C1_Tasks() when the interrupt driven FIFO read has finished.
+ \param[in] error - bus status of the finished transaction \n
+ \param[in] ptr - unused \n
+ \return void \n
+ */
+static void BMA253_FifoReadComplete(i2c1_error_t error, void *ptr);
+/**
+ \ingroup BMA253
+ \brief \n
+ * This API function is used private within the source file. It is called from
+ the interrupt on change of the ACCEL_INT1 pin when the BMA253 has a new sample,
+ or when the FIFO has reached its watermark while the FIFO is enabled.
+ \return void \n
+ */
+static void BMA253_Int1Handler(void);
+
+static volatile bool accelDataReady = false;                /**< Set from the ACCEL_INT1 interrupt on change when a new sample is available */
+
+static uint8_t accelReadBlock[ACCEL_DATA_BLOCK_SIZE];       /**< Data registers captured by the interrupt driven read */
+static volatile bool accelReadDone = false;                 /**< Set from I2C1_Tasks() when the interrupt driven read has finished */
+static volatile i2c1_error_t accelReadError;                /**< Bus status of the last interrupt driven read */
+
+static i2c1_transaction_t accelTransaction = {
+    BMA253_ADDR, I2C1_CLOCK_400KHZ, BMA253_X_LSB_ADDR, true,
+    accelReadBlock, sizeof(accelReadBlock),
+    BMA253_AccelDataReadComplete, NULL
+};
+
+static volatile bool fifoEnabled = false;                   /**< INT1 signals the FIFO watermark instead of new data */
+static uint8_t fifoStatus;                                  /**< FIFO Status captured ahead of the frames by the interrupt driven read */
+static uint8_t fifoReadBlock[BMA253_FIFO_WATERMARK * BMA253_FIFO_FRAME_SIZE];   /**< FIFO frames captured by the interrupt driven read */
+static volatile bool fifoWatermark = false;                 /**< Set from the ACCEL_INT1 interrupt on change when the FIFO watermark is reached */
+static bool fifoReadBusy = false;                           /**< Interrupt driven FIFO read queued, or its frames not taken yet */
+static volatile bool fifoReadDone = false;                  /**< Set from I2C1_Tasks() when the interrupt driven FIFO read has finished */
+static volatile i2c1_error_t fifoReadError;                 /**< Bus status of the last interrupt driven FIFO read */
+
+static i2c1_transaction_t fifoStatusTransaction = {
+    BMA253_ADDR, I2C1_CLOCK_400KHZ, BMA253_FIFO_STATUS_ADDR, true,
+    &fifoStatus, sizeof(fifoStatus),
+    NULL, NULL
+};
+
+static i2c1_transaction_t fifoTransaction = {
+    BMA253_ADDR, I2C1_CLOCK_400KHZ, BMA253_FIFO_DATA_ADDR, true,
+    fifoReadBlock, sizeof(fifoReadBlock),
+    BMA253_FifoReadComplete, NULL
+};
+
+static i2c1_transaction_t * const fifoBatch[] = {
+    &fifoStatusTransaction, &fifoTransaction
+};
 
 void BMA253_Initialize(void)
 {
     i2c_write1ByteRegister(BMA253_ADDR, BMA253_PWR_MODE_ADDR, BMA253_NORMAL_MODE);
     i2c_write1ByteRegister(BMA253_ADDR, BMA253_BW_SELECT_ADDR, BMA253_BW_7_81HZ);
     i2c_write1ByteRegister(BMA253_ADDR, BMA253_RANGE_ADDR, BMA253_2G_RANGE);
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_FIFO_CONFIG_1_ADDR, BMA253_FIFO_MODE_BYPASS);
+    
+    // new data interrupt -> INT1 -> ACCEL_INT1 positive edge interrupt on change
+    IOCAF6_SetInterruptHandler(BMA253_Int1Handler);
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_INT_DATA_ADDR, BMA253_INT1_DATA);
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_INT_EN_1_ADDR, BMA253_DATA_INT_EN);
 }
 
 void BMA253_GetAccelDataX(int16_t *xAccelData)
 {
-    uint8_t lsbData;
-    uint8_t msbData;
-    while(!BMA253_NewAccelDataRdyX())
-    {
-        // Do Nothing until we have new data ready in the register
-    }
-    
-    lsbData = i2c_read1ByteRegister(BMA253_ADDR, BMA253_X_LSB_ADDR);
-    msbData = i2c_read1ByteRegister(BMA253_ADDR, BMA253_X_MSB_ADDR);
-    *xAccelData = ( (((int16_t)msbData) << 8) | (lsbData) ) >> 4;
+    *xAccelData = BMA253_ReadAxis(BMA253_X_LSB_ADDR);
 }
 
 void BMA253_GetAccelDataY(int16_t *yAccelData)
 {
-    uint8_t lsbData;
-    uint8_t msbData;
-    while(!BMA253_NewAccelDataRdyY())
-    {
-        // Do Nothing until we have new data ready in the register
-    }
-    
-    lsbData = i2c_read1ByteRegister(BMA253_ADDR, BMA253_Y_LSB_ADDR);
-    msbData = i2c_read1ByteRegister(BMA253_ADDR, BMA253_Y_MSB_ADDR);
-    *yAccelData = ( (((int16_t)msbData) << 8) | (lsbData) ) >> 4;
+    *yAccelData = BMA253_ReadAxis(BMA253_Y_LSB_ADDR);
 }
 
 void BMA253_GetAccelDataZ(int16_t *zAccelData)
 {
-    uint8_t lsbData;
-    uint8_t msbData;
-    while(!BMA253_NewAccelDataRdyZ())
-    {
-        // Do Nothing until we have new data ready in the register
-    }
-    
-    lsbData = i2c_read1ByteRegister(BMA253_ADDR, BMA253_Z_LSB_ADDR);
-    msbData = i2c_read1ByteRegister(BMA253_ADDR, BMA253_Z_MSB_ADDR);
-    *zAccelData = ( (((int16_t)msbData) << 8) | (lsbData) ) >> 4;
+    *zAccelData = BMA253_ReadAxis(BMA253_Z_LSB_ADDR);
 }
 
 void BMA253_GetAccelDataXYZ(BMA253_ACCEL_DATA_t *accelData)
 {
-    int16_t sensorValue;
-    while (!BMA253_NewAccelDataRdyX())
-    {
-        // Do Nothing until we have new data ready in the register
-    }
+    uint8_t accelBlock[ACCEL_DATA_BLOCK_SIZE];
     
-    BMA253_GetAccelDataX(&sensorValue);
-    accelData->x = sensorValue;
-    
-    while (!BMA253_NewAccelDataRdyY())
-    {
-        // Do Nothing until we have new data ready in the register
-    }
-    
-    BMA253_GetAccelDataY(&sensorValue);
-    accelData->y = sensorValue;
-    
-     while (!BMA253_NewAccelDataRdyZ())
-    {
-        // Do Nothing until we have new data ready in the register
-    }
-    
-    BMA253_GetAccelDataZ(&sensorValue);
-    accelData->z = sensorValue;
+    // X LSB -> Z MSB in one transaction; register address auto-increments
+    i2c_readDataBlock(BMA253_ADDR, BMA253_X_LSB_ADDR, accelBlock, sizeof(accelBlock));
+    BMA253_DecodeFrames(accelBlock, accelData, 1);
 }
 
 uint8_t BMA253_GetAccelChipId(void)
@@ -147,30 +187,165 @@ uint8_t BMA253_GetAccelChipId(void)
     return i2c_read1ByteRegister(BMA253_ADDR, BMA253_CHIP_ID_ADDR);
 }
 
-static bool BMA253_NewAccelDataRdyX(void)
+i2c1_transaction_t* BMA253_PrepareAccelDataRead(void)
 {
-    bool xNewData;
-    
-    xNewData = (i2c_read1ByteRegister(BMA253_ADDR, BMA253_X_LSB_ADDR) & DATA_READY_BIT_MASK); //Is new data ready?
+    accelDataReady = false;
+    accelReadDone = false;
+    return &accelTransaction;
+}
+
+bool BMA253_IsAccelDataReady(void)
+{
+    return accelDataReady;
+}
+
+bool BMA253_IsAccelDataReadDone(void)
+{
+    return accelReadDone;
+}
+
+bool BMA253_GetAccelDataReadValue(BMA253_ACCEL_DATA_t *accelData)
+{
+    BMA253_DecodeFrames(accelReadBlock, accelData, 1);
+    return (I2C1_NOERR == accelReadError);
+}
+
+void BMA253_EnableFifo(uint8_t bandwidth)
+{
+    fifoEnabled = true;
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_BW_SELECT_ADDR, bandwidth);
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_FIFO_CONFIG_0_ADDR, BMA253_FIFO_WATERMARK);
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_FIFO_CONFIG_1_ADDR, BMA253_FIFO_MODE_STREAM);
     
-    return xNewData;
+    // FIFO watermark interrupt -> INT1 in place of the new data interrupt
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_INT_DATA_ADDR, BMA253_INT1_FWM);
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_INT_EN_1_ADDR, BMA253_FWM_INT_EN);
 }
 
-static bool BMA253_NewAccelDataRdyY(void)
+void BMA253_DisableFifo(void)
 {
-    bool yNewData;
+    fifoEnabled = false;
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_INT_DATA_ADDR, BMA253_INT1_DATA);
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_INT_EN_1_ADDR, BMA253_DATA_INT_EN);
     
-    yNewData = (i2c_read1ByteRegister(BMA253_ADDR, BMA253_Y_LSB_ADDR) & DATA_READY_BIT_MASK); //Is new data ready?
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_FIFO_CONFIG_1_ADDR, BMA253_FIFO_MODE_BYPASS);
+    i2c_write1ByteRegister(BMA253_ADDR, BMA253_BW_SELECT_ADDR, BMA253_BW_7_81HZ);
+}
+
+uint8_t BMA253_GetFifoFrameCount(void)
+{
+    return i2c_read1ByteRegister(BMA253_ADDR, BMA253_FIFO_STATUS_ADDR) & BMA253_FIFO_FRAME_COUNT_MASK;
+}
+
+uint8_t BMA253_ReadFifoFrames(BMA253_ACCEL_DATA_t *frames)
+{
+    uint8_t fifoBlock[BMA253_FIFO_WATERMARK * BMA253_FIFO_FRAME_SIZE];
+    uint8_t count = BMA253_GetFifoFrameCount();
     
-    return yNewData;
+    if (count > BMA253_FIFO_WATERMARK)
+    {
+        count = BMA253_FIFO_WATERMARK;
+    }
+    if (count)
+    {
+        // all frames in one transaction; the FIFO Data address does not increment
+        i2c_readDataBlock(BMA253_ADDR, BMA253_FIFO_DATA_ADDR, fifoBlock, count * BMA253_FIFO_FRAME_SIZE);
+        BMA253_DecodeFrames(fifoBlock, frames, count);
+    }
+    return count;
+}
+
+bool BMA253_IsFifoReadDone(void)
+{
+    // INT1 stays high while the watermark is reached, no new edge is seen if
+    // the frames were not taken yet or the I2C1 queue was full on the last edge
+    if (fifoEnabled && (fifoWatermark || ACCEL_INT1_GetValue()))
+    {
+        BMA253_StartFifoRead();
+    }
+    return fifoReadDone;
 }
 
-static bool BMA253_NewAccelDataRdyZ(void)
+uint8_t BMA253_GetFifoReadFrames(BMA253_ACCEL_DATA_t *frames)
 {
-    bool zNewData;
+    uint8_t count = 0;
     
-    zNewData = (i2c_read1ByteRegister(BMA253_ADDR, BMA253_Z_LSB_ADDR) & DATA_READY_BIT_MASK); //Is new data ready?
+    if (I2C1_NOERR == fifoReadError)
+    {
+        // frames counted by the FIFO Status read ahead of the burst read
+        count = fifoStatus & BMA253_FIFO_FRAME_COUNT_MASK;
+        if (count > BMA253_FIFO_WATERMARK)
+        {
+            count = BMA253_FIFO_WATERMARK;
+        }
+        BMA253_DecodeFrames(fifoReadBlock, frames, count);
+    }
+    fifoReadDone = false;
+    fifoReadBusy = false;
+    return count;
+}
+
+static int16_t BMA253_ReadAxis(uint8_t lsbAddress)
+{
+    uint8_t axisData[AXIS_DATA_BLOCK_SIZE];
     
-    return zNewData;
+    i2c_readDataBlock(BMA253_ADDR, lsbAddress, axisData, sizeof(axisData));
+    return BMA253_DecodeAxis(axisData);
 }
 
+static int16_t BMA253_DecodeAxis(const uint8_t *axisData)
+{
+    return ( (((int16_t)axisData[1]) << 8) | (axisData[0]) ) >> 4;
+}
+
+static void BMA253_DecodeFrames(const uint8_t *block, BMA253_ACCEL_DATA_t *frames, uint8_t count)
+{
+    while (count--)
+    {
+        frames->x = BMA253_DecodeAxis(&block[0]);
+        frames->y = BMA253_DecodeAxis(&block[2]);
+        frames->z = BMA253_DecodeAxis(&block[4]);
+        block += BMA253_FIFO_FRAME_SIZE;
+        frames++;
+    }
+}
+
+static void BMA253_AccelDataReadComplete(i2c1_error_t error, void *ptr)
+{
+    accelReadError = error;
+    accelReadDone = true;
+}
+
+static void BMA253_StartFifoRead(void)
+{
+    if (fifoReadBusy)
+    {
+        return;
+    }
+    fifoWatermark = false;
+    // no frames are reported if the FIFO Status read fails
+    fifoStatus = 0;
+    if (I2C1_NOERR == I2C1_SubmitBatch(fifoBatch, sizeof(fifoBatch) / sizeof(fifoBatch[0])))
+    {
+        fifoReadBusy = true;
+    }
+}
+
+static void BMA253_FifoReadComplete(i2c1_error_t error, void *ptr)
+{
+    fifoReadError = error;
+    fifoReadDone = true;
+}
+
+static void BMA253_Int1Handler(void)
+{
+    // the read is queued from BMA253_IsFifoReadDone, outside of the interrupt
+    if (fifoEnabled)
+    {
+        fifoWatermark = true;
+    }
+    else
+    {
+        accelDataReady = true;
+    }
+}
@@ -29,6 +29,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "../i2c1_master.h"
 
 /**
 \ingroup BMA253
@@ -106,7 +107,7 @@ This is a macro to access the BMA253 sensitivity range configuration register
 \ingroup BMA253
 \def BMA253_INT_EN_1_ADDR
 This is a macro to access the BMA253 Interrupt Enable (1) bit
-bit 4 [data ready interrupt] '0'-> disabled '1'-> enabled
+bit 6 [FIFO watermark interrupt] | bit 4 [data ready interrupt] '0'-> disabled '1'-> enabled
 */
 #define BMA253_INT_EN_1_ADDR                (0x17) 
 /**
@@ -119,9 +120,65 @@ This is a macro to access the BMA253 Interrupt Pin Configuration
 \ingroup BMA253
 \def BMA253_INT_DATA_ADDR
 This is a macro to access the BMA253 Interrupt Data bit
-bit 0 [data ready to int1 pin] '0'-> disabled '1'-> enabled
+bit 1 [FIFO watermark to int1 pin] | bit 0 [data ready to int1 pin] '0'-> disabled '1'-> enabled
 */
 #define BMA253_INT_DATA_ADDR                (0x1A)
+/**
+\ingroup BMA253
+\def BMA253_DATA_INT_EN
+This is a macro used to set the data ready interrupt enable bit of \ref BMA253_INT_EN_1_ADDR
+*/
+#define BMA253_DATA_INT_EN                  (0x10)
+/**
+\ingroup BMA253
+\def BMA253_INT1_DATA
+This is a macro used to set the data ready to int1 pin bit of \ref BMA253_INT_DATA_ADDR
+*/
+#define BMA253_INT1_DATA                    (0x01)
+/**
+\ingroup BMA253
+\def BMA253_FWM_INT_EN
+This is a macro used to set the FIFO watermark interrupt enable bit of \ref BMA253_INT_EN_1_ADDR
+*/
+#define BMA253_FWM_INT_EN                   (0x40)
+/**
+\ingroup BMA253
+\def BMA253_INT1_FWM
+This is a macro used to set the FIFO watermark to int1 pin bit of \ref BMA253_INT_DATA_ADDR
+*/
+#define BMA253_INT1_FWM                     (0x02)
+
+/* FIFO REGISTER ADRESSES */
+
+/**
+\ingroup BMA253
+\def BMA253_FIFO_STATUS_ADDR
+This is a macro to access the BMA253 FIFO Status register
+bit 7 [FIFO overrun] | bits 6:0 [frames stored in the FIFO]
+*/
+#define BMA253_FIFO_STATUS_ADDR             (0x0E)
+/**
+\ingroup BMA253
+\def BMA253_FIFO_CONFIG_0_ADDR
+This is a macro to access the BMA253 FIFO Watermark level register
+bits 5:0 [watermark level in frames]
+*/
+#define BMA253_FIFO_CONFIG_0_ADDR           (0x30)
+/**
+\ingroup BMA253
+\def BMA253_FIFO_CONFIG_1_ADDR
+This is a macro to access the BMA253 FIFO Configuration register
+bits 7:6 [FIFO mode] | bits 1:0 [axes stored in each frame]
+A write to this register clears the FIFO.
+*/
+#define BMA253_FIFO_CONFIG_1_ADDR           (0x3E)
+/**
+\ingroup BMA253
+\def BMA253_FIFO_DATA_ADDR
+This is a macro to access the BMA253 FIFO Data output register
+A burst read on this address does not increment, consecutive frames are returned.
+*/
+#define BMA253_FIFO_DATA_ADDR               (0x3F)
 
 /* POWER MODE DEFINITONS */
 
@@ -133,6 +190,53 @@ default power mode
 */
 #define BMA253_NORMAL_MODE                  (0x00)
 
+/* FIFO SETTINGS */
+
+/**
+\ingroup BMA253
+\def BMA253_FIFO_MODE_BYPASS
+This is a macro is used to configure the BMA253 FIFO Bypass mode (FIFO disabled)
+default FIFO mode
+*/
+#define BMA253_FIFO_MODE_BYPASS             (0x00)
+/**
+\ingroup BMA253
+\def BMA253_FIFO_MODE_STREAM
+This is a macro is used to configure the BMA253 FIFO Stream mode, X, Y and Z
+stored in each frame | the oldest frame is discarded when the FIFO is full
+*/
+#define BMA253_FIFO_MODE_STREAM             (0x80)
+/**
+\ingroup BMA253
+\def BMA253_FIFO_FRAME_COUNT_MASK
+This is a macro is used as a mask to filter the frame counter of the FIFO Status register
+*/
+#define BMA253_FIFO_FRAME_COUNT_MASK        (0x7F)
+/**
+\ingroup BMA253
+\def BMA253_FIFO_DEPTH
+This is a macro for the number of frames the BMA253 FIFO can store
+*/
+#define BMA253_FIFO_DEPTH                   (32)
+/**
+\ingroup BMA253
+\def BMA253_FIFO_FRAME_SIZE
+This is a macro for the number of bytes of a X, Y, Z FIFO frame
+*/
+#define BMA253_FIFO_FRAME_SIZE              (6)
+#ifndef BMA253_FIFO_WATERMARK
+/**
+\ingroup BMA253
+\def BMA253_FIFO_WATERMARK
+This is a macro for the FIFO level, in frames, drained by a single burst read.
+It also sizes the frame array passed to \ref BMA253_GetFifoReadFrames
+*/
+#define BMA253_FIFO_WATERMARK               (8)
+#endif
+#if (BMA253_FIFO_WATERMARK == 0) || (BMA253_FIFO_WATERMARK > BMA253_FIFO_DEPTH)
+#error "BMA253_FIFO_WATERMARK must be between 1 and BMA253_FIFO_DEPTH"
+#endif
+
 /* BANDWITH SETTINGS */
 
 /**
@@ -183,6 +287,13 @@ This is a macro is used to configure the BMA253 Bandwidth to 500 Hz
 This is a macro is used to configure the BMA253 Bandwidth to 1000 Hz
 */
 #define BMA253_BW_1KHZ                      (0x0F)
+/**
+\ingroup BMA253
+\def BMA253_SAMPLE_PERIOD_MS
+This is a macro is used for the output data period at BMA253_BW_7_81HZ, in ms.
+The data rate is twice the bandwidth, 15.63 Hz
+*/
+#define BMA253_SAMPLE_PERIOD_MS             (64)
 
 /* ACCEL G-RANGE SETTINGS */
 
@@ -231,7 +342,8 @@ typedef struct
  \ingroup BMA253
  \brief This public function is used to initialize the BMA253 according to the demonstration
  requirements. \n
- Normal Mode of operation, using 7.81 Hz bandwidth supporting 2 G's measurement. 
+ Normal Mode of operation, using 7.81 Hz bandwidth supporting 2 G's measurement, FIFO bypassed. 
+ The new data interrupt is routed to the INT1 pin (ACCEL_INT1), see \ref BMA253_IsAccelDataReady. 
  \return null \n 
  */
 void BMA253_Initialize(void);
@@ -265,7 +377,10 @@ void BMA253_GetAccelDataZ(int16_t *zAccelData);
 /**
  \ingroup BMA253
  \brief  This is the public function called to capture the Signed 
- Z-Axis Acceleration Value \n
+ X, Y and Z-Axis Acceleration Values \n
+ All (6) data registers are captured with a single auto-incrementing burst read
+ (X LSB -> Z MSB), the 12-bit values are decoded from that block. The latest
+ sample is returned, use \ref BMA253_IsAccelDataReady to wait for a new one. \n
  \param[in] BMA253_ACCEL_DATA_t - *accelData; (48-bit structure used for X,Y,Z Data)
  This passed parameter is used to pass updated values back up through function call using
  the *pointer reference to the object variable \n
@@ -280,6 +395,102 @@ void BMA253_GetAccelDataXYZ(BMA253_ACCEL_DATA_t *accelData);
  \retval unsigned 8 bit value used to represent BMA Chip ID value \n
  */
 uint8_t BMA253_GetAccelChipId(void);
+/**
+ \ingroup BMA253
+ \brief  This is the public function used to prepare an interrupt driven burst
+ read of the X, Y and Z data registers. The returned descriptor is queued alone
+ or as part of a batch; completion is reported through \ref BMA253_IsAccelDataReadDone.
+ The new data signal of \ref BMA253_IsAccelDataReady is consumed. \n
+ \return Transaction descriptor of the read \n 
+ \retval i2c1_transaction_t* - pass to I2C1_SubmitTransaction or I2C1_SubmitBatch \n
+ */
+i2c1_transaction_t* BMA253_PrepareAccelDataRead(void);
+/**
+ \ingroup BMA253
+ \brief  This is the public function used to check if the BMA253 signalled a new
+ sample on the INT1 pin since the last \ref BMA253_PrepareAccelDataRead \n
+ \return New data state \n 
+ \retval bool true - new sample available | false - no new sample yet \n
+ */
+bool BMA253_IsAccelDataReady(void);
+/**
+ \ingroup BMA253
+ \brief  This is the public function used to check if the read started by
+ \ref BMA253_PrepareAccelDataRead has finished on the bus \n
+ \return Read completion state \n 
+ \retval bool true - read finished | false - read in progress or not started \n
+ */
+bool BMA253_IsAccelDataReadDone(void);
+/**
+ \ingroup BMA253
+ \brief  This is the public function used to decode the X, Y and Z values
+ captured by the last finished \ref BMA253_PrepareAccelDataRead \n
+ \param[in] BMA253_ACCEL_DATA_t - *accelData; (48-bit structure used for X,Y,Z Data) \n
+ \return Status of the finished read \n 
+ \retval bool true - data is valid | false - I2C bus error \n
+ */
+bool BMA253_GetAccelDataReadValue(BMA253_ACCEL_DATA_t *accelData);
+/**
+ \ingroup BMA253
+ \brief  This is the public function used to start capturing samples in the FIFO \n
+ The FIFO is cleared and configured in Stream mode with a watermark of
+ \ref BMA253_FIFO_WATERMARK frames. Samples are stored at twice the selected
+ bandwidth, \ref BMA253_BW_31_25HZ -> \ref BMA253_BW_500HZ giving 62.5 -> 1000 Hz.
+ The FIFO watermark interrupt is routed to the INT1 pin in place of the new data
+ interrupt; each watermark leads to an interrupt driven read of the frames, see
+ \ref BMA253_IsFifoReadDone. \n
+ \param[in] bandwidth - BMA253_BW_xxx bandwidth setting \n
+ \return void \n 
+ */
+void BMA253_EnableFifo(uint8_t bandwidth);
+/**
+ \ingroup BMA253
+ \brief  This is the public function used to stop the FIFO and return to reading
+ the data registers. The bandwidth and the new data interrupt set by
+ \ref BMA253_Initialize are restored. \n
+ \return void \n 
+ */
+void BMA253_DisableFifo(void);
+/**
+ \ingroup BMA253
+ \brief  This is the public function used to retrieve the number of frames stored in the FIFO \n
+ \return Frames stored in the FIFO \n 
+ \retval unsigned 8 bit value, 0 -> \ref BMA253_FIFO_DEPTH \n
+ */
+uint8_t BMA253_GetFifoFrameCount(void);
+/**
+ \ingroup BMA253
+ \brief  This is the public function used to drain the FIFO \n
+ The frame counter is read, and up to \ref BMA253_FIFO_WATERMARK of the stored
+ frames are read with a single burst read of the FIFO Data register. It is
+ the blocking alternative to the watermark driven read, do not mix both. \n
+ \param[in] frames - array of at least \ref BMA253_FIFO_WATERMARK frames receiving the samples, oldest first \n
+ \return Number of frames returned \n 
+ \retval unsigned 8 bit value, 0 -> \ref BMA253_FIFO_WATERMARK \n
+ */
+uint8_t BMA253_ReadFifoFrames(BMA253_ACCEL_DATA_t *frames);
+/**
+ \ingroup BMA253
+ \brief  This is the public function used to check if the interrupt driven FIFO
+ read has finished on the bus. Call it from the main loop while the FIFO is enabled. \n
+ Once the watermark interrupt on INT1 was signalled, the FIFO Status and up to
+ \ref BMA253_FIFO_WATERMARK frames are queued from here as one I2C1 batch. The
+ next read is only queued once the frames have been taken with
+ \ref BMA253_GetFifoReadFrames. \n
+ \return Read completion state \n 
+ \retval bool true - read finished | false - read in progress or not started \n
+ */
+bool BMA253_IsFifoReadDone(void);
+/**
+ \ingroup BMA253
+ \brief  This is the public function used to decode the frames captured by the
+ last finished interrupt driven FIFO read, see \ref BMA253_IsFifoReadDone \n
+ Only the frames counted by the FIFO Status read are returned. \n
+ \param[in] frames - array of at least \ref BMA253_FIFO_WATERMARK frames receiving the samples, oldest first \n
+ \return Number of frames returned \n 
+ \retval unsigned 8 bit value, 0 -> \ref BMA253_FIFO_WATERMARK | 0 - I2C bus error \n
+ */
+uint8_t BMA253_GetFifoReadFrames(BMA253_ACCEL_DATA_t *frames);
 
 #endif	/* BMA253_ACCEL_H */
 
@@ -35,7 +35,9 @@
 #include "BMA253_accel.h"
 #include "MCP9844_temp_sensor.h"
 #include "../pin_manager.h"
+#include "../tmr0.h"
 #include "../drivers/uart.h"
+#include "../config/BLE_Explorer_config.h"
 
 /**
 \ingroup LIGHTBLUE
@@ -91,6 +93,173 @@
 #define TERMINATION_BYTE            (']')
 /**
 \ingroup LIGHTBLUE
+\def ESCAPE_BYTE
+ * Macro used to add the character used to escape a payload BYTE in binary encoding.
+ * A payload byte equal to START_BYTE, TERMINATION_BYTE or ESCAPE_BYTE is sent as
+ * ESCAPE_BYTE followed by the byte XOR ESCAPE_MASK. \n
+ \return void \n
+*/
+#define ESCAPE_BYTE                 ('\\')
+/**
+\ingroup LIGHTBLUE
+\def ESCAPE_MASK
+ * Macro used to alter an escaped payload BYTE in binary encoding, so the framing
+ * characters never appear inside the payload. \n
+ \return void \n
+*/
+#define ESCAPE_MASK                 (0x20)
+/**
+\ingroup LIGHTBLUE
+\def ENCODING_ASCII_HEX
+ * Macro used to select the ASCII hex payload encoding through the 'F' packet.
+ * Every payload byte is sent as (2) hex characters, default encoding. \n
+ \return void \n
+*/
+#define ENCODING_ASCII_HEX          (0x00)
+/**
+\ingroup LIGHTBLUE
+\def ENCODING_BINARY
+ * Macro used to select the binary payload encoding through the 'F' packet.
+ * Every payload byte is sent raw, escaped when needed. \n
+ \return void \n
+*/
+#define ENCODING_BINARY             (0x01)
+/**
+\ingroup LIGHTBLUE
+\def ENCODING_COMPOSITE
+ * Macro used to select, through the 'F' packet, the composite 'C' packet carrying
+ * all the sensor and IO records of a timer tick. Combined with ENCODING_ASCII_HEX
+ * or ENCODING_BINARY. \n
+ \return void \n
+*/
+#define ENCODING_COMPOSITE          (0x02)
+/**
+\ingroup LIGHTBLUE
+\def ENCODING_MODE_MASK
+ * Macro used to MASK the supported encoding bits of the 'F' packet. \n
+ \return void \n
+*/
+#define ENCODING_MODE_MASK          (ENCODING_BINARY | ENCODING_COMPOSITE)
+/**
+\ingroup LIGHTBLUE
+\def COMPOSITE_FRAME_SIZE
+ * Macro used to size the buffer of the composite 'C' packet. One tick of records
+ * (T, X, P, L, L) takes (21) bytes. \n
+ \return void \n
+*/
+#define COMPOSITE_FRAME_SIZE        (32)
+/**
+\ingroup LIGHTBLUE
+\def RECORD_HEADER_SIZE
+ * Macro used for the (ID, Length) header size of a record in the composite 'C' packet. \n
+ \return void \n
+*/
+#define RECORD_HEADER_SIZE          (2)
+/**
+\ingroup LIGHTBLUE
+\def TX_STAGE_SIZE
+ * Macro used to size the buffer collecting the characters of a packet before they
+ * are handed to the RN487X in one block write. \n
+ \return void \n
+*/
+#define TX_STAGE_SIZE               (16)
+/**
+\ingroup LIGHTBLUE
+\def PACKET_FRAMING_SIZE
+ * Macro used for the number of framing characters of a packet: START_BYTE, sequence,
+ * Type ID, (2) length characters and TERMINATION_BYTE. \n
+ \return void \n
+*/
+#define PACKET_FRAMING_SIZE         (6)
+/**
+\ingroup LIGHTBLUE
+\def LINK_STATS_SIZE
+ * Macro used to size the payload of the 'D' packet: UART index, (6) 16bit counters
+ * and (2) ring high-water marks. \n
+ \return void \n
+*/
+#define LINK_STATS_SIZE             (15)
+#ifndef KEEP_ALIVE_TICKS
+/**
+\ingroup LIGHTBLUE
+\def KEEP_ALIVE_TICKS
+ * Macro used to configure the maximum number of timer ticks an unchanged sensor or IO
+ * value is held back before it is sent again. \n
+ \return void \n
+*/
+#define KEEP_ALIVE_TICKS            (10)
+#endif
+#ifndef CONN_INTERVAL_MIN
+/**
+\ingroup LIGHTBLUE
+\def CONN_INTERVAL_MIN
+ * Macro used to configure the minimum connection interval requested once the stream
+ * is open, in 1.25 ms units. (0x000C) is 15 ms, the lowest minimum iOS accepts; the
+ * 7.5 ms floor of the specification is refused by iOS centrals. \n
+ \return void \n
+*/
+#define CONN_INTERVAL_MIN           (0x000C)
+#endif
+#ifndef CONN_INTERVAL_MAX
+/**
+\ingroup LIGHTBLUE
+\def CONN_INTERVAL_MAX
+ * Macro used to configure the maximum connection interval requested, in 1.25 ms units.
+ * iOS requires it to be at least 15 ms above CONN_INTERVAL_MIN, (0x0018) is 30 ms. \n
+ \return void \n
+*/
+#define CONN_INTERVAL_MAX           (0x0018)
+#endif
+#ifndef CONN_LATENCY
+/**
+\ingroup LIGHTBLUE
+\def CONN_LATENCY
+ * Macro used to configure the slave latency requested, in connection events. Latency
+ * delays the LED commands written by the central, so it is (0) by default. \n
+ \return void \n
+*/
+#define CONN_LATENCY                (0x0000)
+#endif
+#ifndef CONN_TIMEOUT
+/**
+\ingroup LIGHTBLUE
+\def CONN_TIMEOUT
+ * Macro used to configure the supervision timeout requested, in 10 ms units. \n
+ \return void \n
+*/
+#define CONN_TIMEOUT                (0x01F4)
+#endif
+/**
+\ingroup LIGHTBLUE
+\def ACCEL_READY_TICKS
+ * Macro used for the TMR0 ticks a requested accelerometer read waits for INT1. Past one
+ * output data period the sample registers are read anyway, so a missed INT1 edge does
+ * not hold the telemetry frame. \n
+ \return void \n
+*/
+#define ACCEL_READY_TICKS           ((uint16_t)((uint32_t)BMA253_SAMPLE_PERIOD_MS * TMR0_TICK_FREQUENCY / 1000))
+#ifndef TEMPERATURE_DEADBAND
+/**
+\ingroup LIGHTBLUE
+\def TEMPERATURE_DEADBAND
+ * Macro used to configure the temperature change, in 1/16 degree C, ignored against
+ * the last sent 'T' value. \n
+ \return void \n
+*/
+#define TEMPERATURE_DEADBAND        (4)
+#endif
+#ifndef ACCEL_DEADBAND
+/**
+\ingroup LIGHTBLUE
+\def ACCEL_DEADBAND
+ * Macro used to configure the acceleration change, in counts of each axis, ignored
+ * against the last sent 'X' value. \n
+ \return void \n
+*/
+#define ACCEL_DEADBAND              (16)
+#endif
+/**
+\ingroup LIGHTBLUE
 \def ERROR_LED_VALUE
  * Macro used to access the representation of the ERROR LED State.
  * On the PIC this is through the GPIO bitMap exchanged with the RN487X module.
@@ -100,15 +269,6 @@
 #define ERROR_LED_VALUE             (bitMap.ioStateBitMap.p2_2_state)
 /**
 \ingroup LIGHTBLUE
-\def CMD_MODE_DELAY_TIME
- * Macro used to configure the MCUs BLOCKING delay length (mS) between MCU and
- * RN487X module communication. This delay is required for processing of some
- * requested actions. \n
- \return void \n
-*/
-#define CMD_MODE_DELAY_TIME         (20)
-/**
-\ingroup LIGHTBLUE
 \def LED_OFF_STATE
  * Macro used to indicate the Board Specific Package (BSP) setting for the LED
  * bias configuration, determined on the ACTIVE_STATE tied High/Low. 
@@ -166,6 +326,41 @@
  \return void \n
 */
 #define NIBBLE_MASK                 (0x01)
+/**
+\ingroup LIGHTBLUE
+\def SENSOR_BATCH_SIZE
+ * Macro used to size the I2C1 batch holding one tick worth of sensor reads. \n
+ \return void \n
+*/
+#define SENSOR_BATCH_SIZE           (2)
+/**
+\ingroup LIGHTBLUE
+\def ACCEL_DATA_MASK
+ * Macro used to MASK the top nibble of the acceleration values, as Light Blue expects it cleared. \n
+ \return void \n
+*/
+#define ACCEL_DATA_MASK             (0x0FFF)
+/**
+\ingroup LIGHTBLUE
+\def LINK_OPEN_EVENT
+ * Macro used for the RN487X Event after which the link carries the application data. \n
+ \return void \n
+*/
+#if BLE_PRIVATE_SERVICE
+#define LINK_OPEN_EVENT             RN487X_EVENT_CONNECT
+#else
+#define LINK_OPEN_EVENT             RN487X_EVENT_STREAM_OPEN
+#endif
+#if BLE_PRIVATE_SERVICE
+/**
+\ingroup LIGHTBLUE
+\def GATT_SERVICE_UUID
+ * Macro used for the UUID of the private service. Its characteristics share the UUID,
+ * with the (2) bytes after the first changed to 0001 - 0005. \n
+ \return void \n
+*/
+#define GATT_SERVICE_UUID           "4C420000B7E54F2AA2D1DE7A0C4E51A6"
+#endif
 /**
  \ingroup LIGHTBLUE
 *! \struct PROTOCOL_PACKET_TYPES_t
@@ -183,7 +378,10 @@ typedef enum
     ACCEL_DATA_ID          = 'X',
     SERIAL_DATA_ID         = 'S',
     ERROR_ID               = 'R',
-    UI_CONFIG_DATA_ID      = 'U'
+    UI_CONFIG_DATA_ID      = 'U',
+    ENCODING_MODE_ID       = 'F',
+    COMPOSITE_DATA_ID      = 'C',
+    LINK_STATS_ID          = 'D'
 }PROTOCOL_PACKET_TYPES_t;
 /**
  \ingroup LIGHTBLUE
@@ -203,11 +401,97 @@ typedef enum
     PAYLOAD_1               = 6        
            
 }PACKET_PARSER_STATE_t;
+/**
+ \ingroup LIGHTBLUE
+*! \struct SENSOR_READ_STATE_t
+* A struct used to track the interrupt driven I2C read of a sensor. Requests are
+issued by the public sensor functions and advanced in \ref LIGHTBLUE_SensorTasks
+while the I2C bus runs from the SSP1 interrupt. 
+*/
+typedef enum
+{
+    SENSOR_IDLE             = 0,
+    SENSOR_REQUESTED        = 1,
+    SENSOR_READING          = 2
+}SENSOR_READ_STATE_t;
+/**
+ \ingroup LIGHTBLUE
+*! \struct REPORT_SLOT_t
+* A struct used to index the last sent value of each reported packet in the
+report cache. 
+*/
+typedef enum
+{
+    TEMPERATURE_REPORT      = 0,
+    ACCEL_REPORT            = 1,
+    BUTTON_REPORT           = 2,
+    DATA_LED_REPORT         = 3,
+    ERROR_LED_REPORT        = 4,
+    REPORT_SLOT_COUNT       = 5
+}REPORT_SLOT_t;
+/**
+ \ingroup LIGHTBLUE
+*! \struct REPORT_CACHE_t
+* A struct used to store the last sent value of a reported packet and the number
+of ticks since it was sent. 
+*/
+typedef struct
+{
+    int16_t value[3];
+    uint8_t age;
+    bool valid;
+}REPORT_CACHE_t;
+#if BLE_PRIVATE_SERVICE
+/**
+ \ingroup LIGHTBLUE
+*! \struct GATT_CHARACTERISTIC_t
+* A struct used to index the characteristics of the private service. Each one
+carries the payload of the packet it replaces, without the framing. 
+*/
+typedef enum
+{
+    GATT_TEMPERATURE        = 0,
+    GATT_ACCEL              = 1,
+    GATT_BUTTON             = 2,
+    GATT_LED                = 3,
+    GATT_SERIAL             = 4,
+    GATT_CHARACTERISTIC_COUNT = 5
+}GATT_CHARACTERISTIC_t;
+#endif
 
 const char * const protocol_version_number = "1.1.0";   /**< Local Const Variable used to represent Light Blue Protocol version used by application */
 static char _hex[] = "0123456789ABCDEF";                /**< Local Variable used for Masking a Hex value result */
 static uint8_t sequenceNumber = 0;                      /**< Local Variable used to keep track of the number of TRANSMIT packets sent from device*/
+static uint8_t encodingMode = ENCODING_ASCII_HEX;       /**< Local Variable used to store the payload encoding negotiated through the 'F' packet */
+static uint8_t compositeFrame[COMPOSITE_FRAME_SIZE];    /**< Local Variable used to collect the records of the composite 'C' packet */
+static uint8_t compositeLength = 0;                     /**< Local Variable used to store the number of bytes in compositeFrame */
+static bool compositeOpen = false;                      /**< Local Variable used to collect the packets of the current tick into compositeFrame */
+static uint8_t txStage[TX_STAGE_SIZE];                  /**< Local Variable used to collect packet characters for a block write */
+static uint8_t txStageLength = 0;                       /**< Local Variable used to store the number of characters in txStage */
+static volatile bool bleTxDrained = true;               /**< Local Variable set from the EUSART TX interrupt once all written characters left the ring */
 static volatile rn487x_gpio_bitmap_t bitMap;            /**< Local Variable used managing stored state of GPIO pin controlled by RN487X */
+static SENSOR_READ_STATE_t temperatureState = SENSOR_IDLE;  /**< Local Variable used to track the temperature sensor read */
+static SENSOR_READ_STATE_t accelState = SENSOR_IDLE;        /**< Local Variable used to track the accelerometer read */
+static uint16_t accelRequestStamp = 0;                      /**< Local Variable used to store the TMR0 timestamp of the accelerometer request */
+static REPORT_CACHE_t reportCache[REPORT_SLOT_COUNT];       /**< Local Variable used to store the last sent value per reported packet */
+static bool versionSent = false;                            /**< Local Variable used to send the 'V' packet once per connection */
+static bool errorLedPending = false;                        /**< Local Variable used to retry an ERROR LED update the RN487X command queue could not take */
+static bool connParamPending = false;                       /**< Local Variable used to request the connection parameters once the link is open */
+#if BLE_PRIVATE_SERVICE
+static const char * const gattUuid[GATT_CHARACTERISTIC_COUNT] = {  /**< Local Const Variable used to store the UUID of each characteristic */
+    "4C420001B7E54F2AA2D1DE7A0C4E51A6", "4C420002B7E54F2AA2D1DE7A0C4E51A6", "4C420003B7E54F2AA2D1DE7A0C4E51A6",
+    "4C420004B7E54F2AA2D1DE7A0C4E51A6", "4C420005B7E54F2AA2D1DE7A0C4E51A6"
+};
+static const uint8_t gattProperties[GATT_CHARACTERISTIC_COUNT] = {  /**< Local Const Variable used to store the properties of each characteristic */
+    RN487X_PROPERTY_READ | RN487X_PROPERTY_NOTIFY, RN487X_PROPERTY_READ | RN487X_PROPERTY_NOTIFY,
+    RN487X_PROPERTY_READ | RN487X_PROPERTY_NOTIFY, RN487X_PROPERTY_READ | RN487X_PROPERTY_WRITE | RN487X_PROPERTY_NOTIFY,
+    RN487X_PROPERTY_WRITE | RN487X_PROPERTY_NOTIFY
+};
+static const uint8_t gattSize[GATT_CHARACTERISTIC_COUNT] = {  /**< Local Const Variable used to store the value size of each characteristic */
+    2, 6, 1, 1, RN487X_CHAR_VALUE_MAX_SIZE
+};
+static uint16_t gattHandle[GATT_CHARACTERISTIC_COUNT];      /**< Local Variable used to store the handle of each characteristic, 0 when not found */
+#endif
 
 /**
  \ingroup LIGHTBLUE
@@ -217,30 +501,144 @@ Format is: [0]    [1]     [2]  [ 3 + 4 ]    [5 -> nSize]  [n+5]
             [    SeqID   Type  Payload Size    Payload       ]
    [0]: '['              : Start Bracket Character
    [1]: '#'              : (0-F) Hex value used for Sequence ID used to maintain track of Rx/Tx Order
-   [2]: 'Type ID'        : (V,L,P,T,X,S,R,U) Char used to Identify Data/Packet Type
+   [2]: 'Type ID'        : (V,L,P,T,X,S,R,U,F,C,D) Char used to Identify Data/Packet Type
  [3+4]: 'Payload Size'   : Size of Data Payload expected starting with Byte 4 --> N
 [5->n]: 'Payload'        : Data of Payload
  [n+5]: ']'              : End Bracket Character
+The payload bytes are encoded according to the negotiated encoding mode.
+ASCII hex: each byte is (2) hex characters and Payload Size counts characters.
+Binary: each byte is sent raw, escaped with ESCAPE_BYTE when it matches a framing
+character, and Payload Size counts the bytes before escaping. The 'V' packet is
+always ASCII hex so the protocol version can be read before negotiation.
+While a telemetry frame is open the sensor and IO packets are added as records of
+the composite 'C' packet instead, see \ref LIGHTBLUE_StartTelemetryFrame.
+ \param[in] packetID - char representing the Type ID \n
+ \param[in] payload - bytes of the payload \n
+ \param[in] length - number of bytes in the payload \n
  \return void \n
  */
-static void LIGHTBLUE_SendPacket(char packetID, char* payload);
+static void LIGHTBLUE_SendPacket(char packetID, const uint8_t *payload, uint8_t length);
 /**
  \ingroup LIGHTBLUE
  \brief  Private function to split a Word (16bit) value into (2) (8bit) Byte values.  \n
-This function is used break a (4) digit, 16bit value into pieces and load it back into
-the payload as a 'char' representation of the number presented as a hex value. This is later
-broken down into Nibble format through the SplitByte code. 
+This function is used break a 16bit value into pieces and load it into the payload,
+low byte first. 
+ \return void \n
+ */
+static void LIGHTBLUE_SplitWord(uint8_t* payload, int16_t value);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function to write a payload Byte to the RN487X in binary encoding.  \n
+This function is used to escape the payload bytes which match a framing character. 
+ \param[in] value - payload byte \n
+ \return void \n
+ */
+static void LIGHTBLUE_WriteEscaped(uint8_t value);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function to add a packet character to the transmit stage buffer.  \n
+The stage buffer is written to the RN487X as one block when it is full.
+ \param[in] value - packet character \n
+ \return void \n
+ */
+static void LIGHTBLUE_StageByte(uint8_t value);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function to write the transmit stage buffer to the RN487X.  \n
+ \return void \n
+ */
+static void LIGHTBLUE_FlushStage(void);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function to compute the number of characters a packet takes on the BLE UART.  \n
+ \param[in] binary - true for binary encoding | false for ASCII hex encoding \n
+ \param[in] payload - bytes of the payload \n
+ \param[in] length - number of bytes in the payload \n
+ \return Number of characters including the framing \n
+ */
+static uint8_t LIGHTBLUE_EncodedSize(bool binary, const uint8_t *payload, uint8_t length);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private handler called from the EUSART TX interrupt once the BLE UART ring has drained.  \n
+ \return void \n
+ */
+static void LIGHTBLUE_TxDrained(void);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private handler of the RN487X Events.  \n
+An open link schedules the request of the CONN_INTERVAL_MIN / CONN_INTERVAL_MAX parameters. A write of the private
+service LED or serial characteristic is performed as the matching packet.
+ \param[in] event - RN487X Event \n
+ \return void \n
+ */
+static void LIGHTBLUE_LinkEvent(const rn487x_event_t *event);
+#if BLE_PRIVATE_SERVICE
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function used to define the private service on the RN487X, and hold it in command mode.  \n
+The service is stored by the RN487X: it is only defined, and the RN487X rebooted, when
+its characteristics are not listed yet.
+ \return void \n
+ */
+static void LIGHTBLUE_SetupPrivateService(void);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function used to look up the handles of the private service characteristics.  \n
+ \return true - every characteristic found | false - RN487X not in command mode or characteristic missing \n
+ */
+static bool LIGHTBLUE_FindCharacteristics(void);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function used to write a packet payload to the characteristic replacing it.  \n
+Serial data is split in values of RN487X_CHAR_VALUE_MAX_SIZE bytes. Packets without a
+characteristic are dropped.
+ \param[in] packetID - char representing the Type ID \n
+ \param[in] payload - bytes of the payload \n
+ \param[in] length - number of bytes in the payload \n
  \return void \n
  */
-static void LIGHTBLUE_SplitWord(char* payload, int16_t value);
+static void LIGHTBLUE_WriteCharacteristic(char packetID, const uint8_t *payload, uint8_t length);
+#endif
 /**
  \ingroup LIGHTBLUE
- \brief  Private function to split a Byte (8bit) value into (2) (4bit) Nibble values.  \n
-This function is used break a (2) digit, 8bit value into pieces and load it back into
-the payload as a 'char' representation of the number presented as a hex value. 
+ \brief  Private function to add a record to the composite 'C' packet.  \n
+Record format is: [ID] [Length] [Payload], with ID the packet Type ID it replaces and
+Length the number of payload bytes. The composite packet is sent first if the record
+does not fit.
+ \param[in] packetID - char representing the Type ID \n
+ \param[in] payload - bytes of the payload \n
+ \param[in] length - number of bytes in the payload \n
  \return void \n
  */
-static void LIGHTBLUE_SplitByte(char* payload, int8_t value);
+static void LIGHTBLUE_AddRecord(char packetID, const uint8_t *payload, uint8_t length);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function to send the composite 'C' packet holding the collected records.  \n
+ \return void \n
+ */
+static void LIGHTBLUE_FlushComposite(void);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function used to check if a packet is carried by the composite 'C' packet.  \n
+ \param[in] packetID - char representing the Type ID \n
+ \return Composite record state \n
+ \retval bool true - 'T', 'X', 'P' or 'L' packet | false - sent on its own \n
+ */
+static bool LIGHTBLUE_IsTelemetryRecord(char packetID);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function used to decide if a value needs to be reported.  \n
+The value is reported when it was never sent, when one of its elements moved more
+than the deadband away from the last sent value, or when it was held back for
+KEEP_ALIVE_TICKS calls. The cache is updated when the value is reported. 
+ \param[in] slot - report cache entry of the value \n
+ \param[in] value - elements of the value \n
+ \param[in] count - number of elements, up to (3) \n
+ \param[in] deadband - change of an element ignored \n
+ \return Report state \n
+ \retval bool true - send the value | false - hold it back \n
+ */
+static bool LIGHTBLUE_ReportChanged(REPORT_SLOT_t slot, const int16_t *value, uint8_t count, int16_t deadband);
 /**
  \ingroup LIGHTBLUE
  \brief  Private function used to request status of PUSH BUTTON reading the PORT value. \n
@@ -280,6 +678,8 @@ static void LIGHTBLUE_SetErrorLedValue(bool value);
  \brief  Private function used process requested actions from the Light Blue application \n
 This function is used to update the state of the ERROR LED which is controlled via the
  * RN487X through the GPIO command on the PIC platform. On the AVR board this is MCU (LAT) controlled.
+ * The commands are queued to the RN487X without waiting for the responses; when the
+ * command queue is full the update is retried from \ref LIGHTBLUE_SensorTasks.
  \return void \n
  */
 static void LIGHTBLUE_UpdateErrorLed(void); 
@@ -292,109 +692,214 @@ For Serial Message Bridge, the string 'message' is iterated through byte by byte
 Supported Type ID Options:
 'L' : LEDs Status Update
 'S' : Serial Data to be bridged through CDC
- \param[in] id - char representing the Type ID ('L' || 'S')  \n
+'F' : Payload encoding of the transmitted packets, bit 0: binary | bit 1: composite
+'D' : Link statistics request, data is the UART index (0: CDC | 1: BLE)
+ \param[in] id - char representing the Type ID ('L' || 'S' || 'F' || 'D')  \n
  \param[in] data - 8bit unsigned value; (- - - - - - ERR DATA), (Single Char from String)\n
  \return void \n
  */
 static void LIGHTBLUE_PerformAction(char id, uint8_t data);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function used to format and send the Temperature Sensor packet \n
+ \return void \n
+ */
+static void LIGHTBLUE_SendTemperature(void);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function used to format and send the Acceleration Sensor packet \n
+ \return void \n
+ */
+static void LIGHTBLUE_SendAccel(void);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function used to format and send the link statistics 'D' packet of a UART \n
+ \param[in] index - UART_CDC or UART_BLE \n
+ \return void \n
+ */
+static void LIGHTBLUE_SendLinkStats(uart_configurations_t index);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Private function used to print a labelled 16bit counter as (4) hex characters to the CDC terminal \n
+ \param[in] label - text printed before the value \n
+ \param[in] value - counter value \n
+ \return void \n
+ */
+static void LIGHTBLUE_PrintCounter(const char *label, uint16_t value);
 
 void LIGHTBLUE_Initialize(void)
 {
     bitMap.ioBitMap.gpioBitMap = 0x01;
     bitMap.ioStateBitMap.gpioStateBitMap = 0x01; 
+    RN487X.SetTxDrainedHandler(LIGHTBLUE_TxDrained);
+    RN487X_SubscribeEvents(LIGHTBLUE_LinkEvent);
+#if BLE_PRIVATE_SERVICE
+    LIGHTBLUE_SetupPrivateService();
+#endif
+    BMA253_Initialize();
 }
 
 void LIGHTBLUE_TemperatureSensor(void)
 {
-    char payload[5];
-    int16_t temperature;
-    
-    *payload = '\0';
-    MCP9844_GetTemperatureValue(&temperature);
-    
-    LIGHTBLUE_SplitWord(payload, temperature);
-    
-    LIGHTBLUE_SendPacket(TEMPERATURE_DATA_ID, payload);
+    // a read still queued or on the bus is left to finish
+    if (temperatureState == SENSOR_IDLE)
+    {
+        temperatureState = SENSOR_REQUESTED;
+    }
 }
 
 void LIGHTBLUE_AccelSensor(void)
 {
-    char payload[13];
-    BMA253_ACCEL_DATA_t accelData;
+    if (accelState == SENSOR_IDLE)
+    {
+        accelState = SENSOR_REQUESTED;
+        accelRequestStamp = TMR0_ReadTimestamp();
+    }
+}
+
+void LIGHTBLUE_SensorTasks(void)
+{
+    i2c1_transaction_t *batch[SENSOR_BATCH_SIZE];
+    uint8_t count = 0;
+    bool readTemperature;
+    bool readAccel;
     
-    *payload = '\0';
-    BMA253_GetAccelDataXYZ(&accelData);
-    // Masking to ensure top nibble is always 0 as light blue expects
-    // Exception may occur when highest byte is not 0
-    LIGHTBLUE_SplitWord(payload, (accelData.x & 0x0FFF)); 
-    LIGHTBLUE_SplitWord(payload, (accelData.y & 0x0FFF));
-    LIGHTBLUE_SplitWord(payload, (accelData.z & 0x0FFF));
+    if (errorLedPending)
+    {
+        LIGHTBLUE_UpdateErrorLed();
+    }
+    // requested from here, the RN487X Event handlers run while the command queue is busy
+    if (connParamPending)
+    {
+        connParamPending = !RN487X_SetConnParamsAsync(CONN_INTERVAL_MIN, CONN_INTERVAL_MAX, CONN_LATENCY, CONN_TIMEOUT, NULL);
+    }
+    readTemperature = (temperatureState == SENSOR_REQUESTED);
+    // the accelerometer is read once INT1 has signalled a new sample, or one sample period later
+    readAccel = (accelState == SENSOR_REQUESTED)
+                && (BMA253_IsAccelDataReady()
+                    || ((uint16_t)(TMR0_ReadTimestamp() - accelRequestStamp) > ACCEL_READY_TICKS));
+
+    // All pending reads of this tick go out as one I2C1 batch
+    if (readTemperature)
+    {
+        batch[count++] = MCP9844_PrepareTemperatureRead();
+    }
+    if (readAccel)
+    {
+        batch[count++] = BMA253_PrepareAccelDataRead();
+    }
+    if (count && (I2C1_NOERR == I2C1_SubmitBatch(batch, count)))
+    {
+        if (readTemperature)
+        {
+            temperatureState = SENSOR_READING;
+        }
+        if (readAccel)
+        {
+            accelState = SENSOR_READING;
+        }
+    }
+
+    if ((temperatureState == SENSOR_READING) && MCP9844_IsTemperatureReadDone())
+    {
+        temperatureState = SENSOR_IDLE;
+        LIGHTBLUE_SendTemperature();
+    }
+    if ((accelState == SENSOR_READING) && BMA253_IsAccelDataReadDone())
+    {
+        accelState = SENSOR_IDLE;
+        LIGHTBLUE_SendAccel();
+    }
     
-    LIGHTBLUE_SendPacket(ACCEL_DATA_ID, payload);
+    // the tick is complete once no sensor read is pending
+    if (compositeOpen && (temperatureState == SENSOR_IDLE) && (accelState == SENSOR_IDLE))
+    {
+        compositeOpen = false;
+        LIGHTBLUE_FlushComposite();
+    }
 }
 
 void LIGHTBLUE_PushButton(void)
 {
-    char payload[3];
     uint8_t button = LIGHTBLUE_GetButtonValue();
+    int16_t value = button;
     
-    *payload = '\0';
-    LIGHTBLUE_SplitByte(payload, button);
-    
-    LIGHTBLUE_SendPacket(BUTTON_STATE_ID, payload);
+    if (LIGHTBLUE_ReportChanged(BUTTON_REPORT, &value, 1, 0))
+    {
+        LIGHTBLUE_SendPacket(BUTTON_STATE_ID, &button, sizeof(button));
+    }
 }
 
 void LIGHTBLUE_LedState(void)
 {
-    char payload[3];
     uint8_t led;
+    int16_t value;
     
     led = DATA_LED_IDENTIFIER + LIGHTBLUE_GetDataLedValue();
-    
-    *payload = '\0';
-    LIGHTBLUE_SplitByte(payload, led);
-    
-    LIGHTBLUE_SendPacket(LED_STATE_ID, payload);
+    value = led;
+    if (LIGHTBLUE_ReportChanged(DATA_LED_REPORT, &value, 1, 0))
+    {
+        LIGHTBLUE_SendPacket(LED_STATE_ID, &led, sizeof(led));
+    }
     
     led = ERROR_LED_IDENTIFIER + LIGHTBLUE_GetErrorLedValue();
-    *payload = '\0';
-    LIGHTBLUE_SplitByte(payload, led);
-    
-    LIGHTBLUE_SendPacket(LED_STATE_ID, payload); 
+    value = led;
+    if (LIGHTBLUE_ReportChanged(ERROR_LED_REPORT, &value, 1, 0))
+    {
+        LIGHTBLUE_SendPacket(LED_STATE_ID, &led, sizeof(led)); 
+    }
 }
 
 void LIGHTBLUE_SendProtocolVersion(void)
 {
-    char payload[19];
-    uint8_t value;
-    uint8_t dataIndex;
-    
-    *payload = '\0';
-    
-    for(dataIndex = 0; dataIndex < strlen(protocol_version_number); dataIndex++)
+    // the version is static for the whole connection
+    if (versionSent)
     {
-        value = protocol_version_number[dataIndex];
-        LIGHTBLUE_SplitByte(payload, value);
+        return;
     }
-    
-    LIGHTBLUE_SendPacket(PROTOCOL_VERSION_ID, payload);
+    versionSent = true;
+    LIGHTBLUE_SendPacket(PROTOCOL_VERSION_ID, (const uint8_t *)protocol_version_number, strlen(protocol_version_number));
 }
 
-void LIGHTBLUE_SendSerialData(char* serialData)
+void LIGHTBLUE_SendSerialData(const char* serialData)
 {
-    uint8_t length = strlen(serialData) * 2;
+    LIGHTBLUE_SendPacket(SERIAL_DATA_ID, (const uint8_t *)serialData, strlen(serialData));
+}
+
+void LIGHTBLUE_ResetSession(void)
+{
+    encodingMode = ENCODING_ASCII_HEX;
+    compositeOpen = false;
+    compositeLength = 0;
+    versionSent = false;
+    memset(reportCache, 0, sizeof(reportCache));
+    connParamPending = false;
+}
+
+void LIGHTBLUE_StartTelemetryFrame(void)
+{
+    compositeOpen = (encodingMode & ENCODING_COMPOSITE) != 0;
+}
+
+void LIGHTBLUE_PrintLinkStats(void)
+{
+    static const char * const uartName[] = {"CDC", "BLE"};
+    eusart_counters_t counters;
+    uart_configurations_t index;
     
-    RN487X.Write(START_BYTE);
-    RN487X.Write(Hex(sequenceNumber++));
-    RN487X.Write(SERIAL_DATA_ID);
-    RN487X.Write(Hex(length >> 4));
-    RN487X.Write(Hex(length));
-    while(*serialData)
+    for (index = UART_CDC; index <= UART_BLE; index++)
     {
-        RN487X.Write(Hex(*serialData >> 4));
-        RN487X.Write(Hex(*serialData++));
+        uart[index].GetCounters(&counters);
+        uart[UART_CDC].WriteBlock((const uint8_t *)uartName[index], strlen(uartName[index]));
+        LIGHTBLUE_PrintCounter(" tx ", counters.txBytes);
+        LIGHTBLUE_PrintCounter(" rx ", counters.rxBytes);
+        LIGHTBLUE_PrintCounter(" ovr ", counters.overrunErrors);
+        LIGHTBLUE_PrintCounter(" fer ", counters.framingErrors);
+        LIGHTBLUE_PrintCounter(" drop ", counters.rxDropped);
+        LIGHTBLUE_PrintCounter(" stall ", counters.txStalls);
+        LIGHTBLUE_PrintCounter(" hw ", ((uint16_t)counters.txHighWater << 8) | counters.rxHighWater);
+        uart[UART_CDC].WriteBlock((const uint8_t *)"\r\n", 2);
     }
-    RN487X.Write(TERMINATION_BYTE);
 }
 
 void LIGHTBLUE_ParseIncomingPacket(char receivedByte)
@@ -457,34 +962,343 @@ void LIGHTBLUE_ParseIncomingPacket(char receivedByte)
     }
 }
 
-static void LIGHTBLUE_SendPacket(char packetID, char* payload)
+static void LIGHTBLUE_SendTemperature(void)
+{
+    uint8_t payload[sizeof(int16_t)];
+    int16_t temperature;
+    
+    if ((MCP9844_GetTemperatureReadValue(&temperature) == false)
+        || (LIGHTBLUE_ReportChanged(TEMPERATURE_REPORT, &temperature, 1, TEMPERATURE_DEADBAND) == false))
+    {
+        return;
+    }
+    
+    LIGHTBLUE_SplitWord(payload, temperature);
+    
+    LIGHTBLUE_SendPacket(TEMPERATURE_DATA_ID, payload, sizeof(payload));
+}
+
+static void LIGHTBLUE_SendAccel(void)
 {
-    RN487X.Write(START_BYTE);
-    RN487X.Write(Hex(sequenceNumber++));
-    RN487X.Write(packetID);
-    RN487X.Write(Hex(strlen(payload) >> 4));
-    RN487X.Write(Hex(strlen(payload)));
-    while (*payload)
+    uint8_t payload[3 * sizeof(int16_t)];
+    int16_t value[3];
+    BMA253_ACCEL_DATA_t accelData;
+    
+    if (BMA253_GetAccelDataReadValue(&accelData) == false)
+    {
+        return;
+    }
+    value[0] = accelData.x;
+    value[1] = accelData.y;
+    value[2] = accelData.z;
+    if (LIGHTBLUE_ReportChanged(ACCEL_REPORT, value, 3, ACCEL_DEADBAND) == false)
     {
-        RN487X.Write((*(uint8_t *)payload++));
+        return;
     }
-    RN487X.Write(TERMINATION_BYTE);
+    // Masking to ensure top nibble is always 0 as light blue expects
+    // Exception may occur when highest byte is not 0
+    LIGHTBLUE_SplitWord(&payload[0], (accelData.x & ACCEL_DATA_MASK)); 
+    LIGHTBLUE_SplitWord(&payload[2], (accelData.y & ACCEL_DATA_MASK));
+    LIGHTBLUE_SplitWord(&payload[4], (accelData.z & ACCEL_DATA_MASK));
+    
+    LIGHTBLUE_SendPacket(ACCEL_DATA_ID, payload, sizeof(payload));
+}
+
+static void LIGHTBLUE_SendLinkStats(uart_configurations_t index)
+{
+    uint8_t payload[LINK_STATS_SIZE];
+    eusart_counters_t counters;
+    
+    uart[index].GetCounters(&counters);
+    payload[0] = index;
+    LIGHTBLUE_SplitWord(&payload[1], counters.txBytes);
+    LIGHTBLUE_SplitWord(&payload[3], counters.rxBytes);
+    LIGHTBLUE_SplitWord(&payload[5], counters.overrunErrors);
+    LIGHTBLUE_SplitWord(&payload[7], counters.framingErrors);
+    LIGHTBLUE_SplitWord(&payload[9], counters.rxDropped);
+    LIGHTBLUE_SplitWord(&payload[11], counters.txStalls);
+    payload[13] = counters.txHighWater;
+    payload[14] = counters.rxHighWater;
+    
+    LIGHTBLUE_SendPacket(LINK_STATS_ID, payload, sizeof(payload));
+}
+
+static void LIGHTBLUE_PrintCounter(const char *label, uint16_t value)
+{
+    uint8_t text[4];
+    
+    text[0] = Hex(value >> 12);
+    text[1] = Hex(value >> 8);
+    text[2] = Hex(value >> 4);
+    text[3] = Hex(value);
+    uart[UART_CDC].WriteBlock((const uint8_t *)label, strlen(label));
+    uart[UART_CDC].WriteBlock(text, sizeof(text));
 }
 
-static void LIGHTBLUE_SplitWord(char* payload, int16_t value)
+static void LIGHTBLUE_SendPacket(char packetID, const uint8_t *payload, uint8_t length)
 {
-    LIGHTBLUE_SplitByte(payload, value);
-    LIGHTBLUE_SplitByte(payload, value >> 8);
+#if BLE_PRIVATE_SERVICE
+    // each payload is the value of its characteristic, no framing is needed
+    LIGHTBLUE_WriteCharacteristic(packetID, payload, length);
+#else
+    bool binary = (encodingMode & ENCODING_BINARY) && (packetID != PROTOCOL_VERSION_ID);
+    uint8_t size = binary ? length : (length << 1);
+    
+    if (compositeOpen && LIGHTBLUE_IsTelemetryRecord(packetID))
+    {
+        LIGHTBLUE_AddRecord(packetID, payload, length);
+        return;
+    }
+    
+    if (((packetID == COMPOSITE_DATA_ID) || LIGHTBLUE_IsTelemetryRecord(packetID))
+        && (bleTxDrained == false)
+        && (RN487X.TxSpace() < LIGHTBLUE_EncodedSize(binary, payload, length)))
+    {
+        // BLE UART is saturated: drop the telemetry rather than wait,
+        // and report every value again on the next tick
+        memset(reportCache, 0, sizeof(reportCache));
+        return;
+    }
+    
+    LIGHTBLUE_StageByte(START_BYTE);
+    LIGHTBLUE_StageByte(Hex(sequenceNumber++));
+    LIGHTBLUE_StageByte(packetID);
+    LIGHTBLUE_StageByte(Hex(size >> 4));
+    LIGHTBLUE_StageByte(Hex(size));
+    while (length--)
+    {
+        if (binary)
+        {
+            LIGHTBLUE_WriteEscaped(*payload++);
+        }
+        else
+        {
+            LIGHTBLUE_StageByte(Hex(*payload >> 4));
+            LIGHTBLUE_StageByte(Hex(*payload++));
+        }
+    }
+    LIGHTBLUE_StageByte(TERMINATION_BYTE);
+    LIGHTBLUE_FlushStage();
+#endif
 }
 
-static void LIGHTBLUE_SplitByte(char* payload, int8_t value)
+static void LIGHTBLUE_SplitWord(uint8_t* payload, int16_t value)
 {
-    payload += strlen(payload);
-    *payload++ = Hex(value >> 4);
-    *payload++ = Hex(value);
-    *payload = '\0';
+    payload[0] = (uint8_t)value;
+    payload[1] = (uint8_t)(value >> 8);
 }
 
+static void LIGHTBLUE_AddRecord(char packetID, const uint8_t *payload, uint8_t length)
+{
+    if ((compositeLength + RECORD_HEADER_SIZE + length) > (uint16_t)COMPOSITE_FRAME_SIZE)
+    {
+        LIGHTBLUE_FlushComposite();
+    }
+    compositeFrame[compositeLength++] = packetID;
+    compositeFrame[compositeLength++] = length;
+    memcpy(&compositeFrame[compositeLength], payload, length);
+    compositeLength += length;
+}
+
+static void LIGHTBLUE_FlushComposite(void)
+{
+    if (compositeLength)
+    {
+        LIGHTBLUE_SendPacket(COMPOSITE_DATA_ID, compositeFrame, compositeLength);
+        compositeLength = 0;
+    }
+}
+
+static bool LIGHTBLUE_ReportChanged(REPORT_SLOT_t slot, const int16_t *value, uint8_t count, int16_t deadband)
+{
+    REPORT_CACHE_t *cache = &reportCache[slot];
+    bool changed = (cache->valid == false) || (++cache->age >= KEEP_ALIVE_TICKS);
+    uint8_t index;
+    int16_t delta;
+    
+    for (index = 0; (index < count) && (changed == false); index++)
+    {
+        delta = value[index] - cache->value[index];
+        changed = (delta > deadband) || (delta < -deadband);
+    }
+    if (changed)
+    {
+        memcpy(cache->value, value, count * sizeof(int16_t));
+        cache->age = 0;
+        cache->valid = true;
+    }
+    return changed;
+}
+
+static bool LIGHTBLUE_IsTelemetryRecord(char packetID)
+{
+    return (packetID == TEMPERATURE_DATA_ID) || (packetID == ACCEL_DATA_ID)
+        || (packetID == BUTTON_STATE_ID) || (packetID == LED_STATE_ID);
+}
+
+static void LIGHTBLUE_WriteEscaped(uint8_t value)
+{
+    if ((value == START_BYTE) || (value == TERMINATION_BYTE) || (value == ESCAPE_BYTE))
+    {
+        LIGHTBLUE_StageByte(ESCAPE_BYTE);
+        value ^= ESCAPE_MASK;
+    }
+    LIGHTBLUE_StageByte(value);
+}
+
+static void LIGHTBLUE_StageByte(uint8_t value)
+{
+    txStage[txStageLength++] = value;
+    if (txStageLength == sizeof(txStage))
+    {
+        LIGHTBLUE_FlushStage();
+    }
+}
+
+static void LIGHTBLUE_FlushStage(void)
+{
+    bleTxDrained = false;
+    RN487X.WriteBlock(txStage, txStageLength);
+    txStageLength = 0;
+}
+
+static uint8_t LIGHTBLUE_EncodedSize(bool binary, const uint8_t *payload, uint8_t length)
+{
+    uint8_t size = PACKET_FRAMING_SIZE;
+    
+    while (length--)
+    {
+        size++;
+        if ((binary == false) || (*payload == START_BYTE)
+            || (*payload == TERMINATION_BYTE) || (*payload == ESCAPE_BYTE))
+        {
+            size++;
+        }
+        payload++;
+    }
+    return size;
+}
+
+static void LIGHTBLUE_TxDrained(void)
+{
+    bleTxDrained = true;
+}
+
+static void LIGHTBLUE_LinkEvent(const rn487x_event_t *event)
+{
+#if BLE_PRIVATE_SERVICE
+    uint8_t index;
+#endif
+    
+    if (event->type == LINK_OPEN_EVENT)
+    {
+        connParamPending = true;
+    }
+#if BLE_PRIVATE_SERVICE
+    else if ((event->type == RN487X_EVENT_CHAR_WRITE) && (event->connection.write.length != 0))
+    {
+        if (event->connection.write.handle == gattHandle[GATT_LED])
+        {
+            LIGHTBLUE_PerformAction(LED_STATE_ID, event->connection.write.value[0]);
+        }
+        else if (event->connection.write.handle == gattHandle[GATT_SERIAL])
+        {
+            for (index = 0; index < event->connection.write.length; index++)
+            {
+                LIGHTBLUE_PerformAction(SERIAL_DATA_ID, event->connection.write.value[index]);
+            }
+        }
+    }
+#endif
+}
+
+#if BLE_PRIVATE_SERVICE
+static void LIGHTBLUE_SetupPrivateService(void)
+{
+    uint8_t index;
+    
+    if (LIGHTBLUE_FindCharacteristics() == false)
+    {
+        // first run, or another private service: define ours in place of it
+        RN487X_ClearPrivateServices();
+        RN487X_SetPrivateService(GATT_SERVICE_UUID);
+        for (index = 0; index < GATT_CHARACTERISTIC_COUNT; index++)
+        {
+            RN487X_SetPrivateCharacteristic(gattUuid[index], gattProperties[index], gattSize[index]);
+        }
+        RN487X_SetServiceBitmap(RN487X_SERVICE_DEVICE_INFO);
+        // the services are applied by the reboot, which also leaves command mode
+        RN487X_RebootCmd();
+        RN487X_WaitForReboot(RN487X_STARTUP_DELAY);
+        if (LIGHTBLUE_FindCharacteristics() == false)
+        {
+            return;
+        }
+    }
+    RN487X_SetCmdModeHeld(true);
+}
+
+static bool LIGHTBLUE_FindCharacteristics(void)
+{
+    // drop the banner of a previous reboot, if any
+    while (RN487X.DataReady())
+    {
+        RN487X.Read();
+    }
+    if (RN487X_EnterCmdMode() == false)
+    {
+        return false;
+    }
+    return (RN487X_GetCharacteristicHandles(gattUuid, gattHandle, GATT_CHARACTERISTIC_COUNT) == GATT_CHARACTERISTIC_COUNT);
+}
+
+static void LIGHTBLUE_WriteCharacteristic(char packetID, const uint8_t *payload, uint8_t length)
+{
+    uint16_t handle;
+    uint8_t size;
+    
+    switch (packetID)
+    {
+        case TEMPERATURE_DATA_ID:
+            handle = gattHandle[GATT_TEMPERATURE];
+            break;
+        case ACCEL_DATA_ID:
+            handle = gattHandle[GATT_ACCEL];
+            break;
+        case BUTTON_STATE_ID:
+            handle = gattHandle[GATT_BUTTON];
+            break;
+        case LED_STATE_ID:
+            handle = gattHandle[GATT_LED];
+            break;
+        case SERIAL_DATA_ID:
+            handle = gattHandle[GATT_SERIAL];
+            break;
+        default:
+            return;
+    }
+    if ((handle == 0) || (length == 0))
+    {
+        return;
+    }
+    
+    do
+    {
+        size = (length > RN487X_CHAR_VALUE_MAX_SIZE) ? RN487X_CHAR_VALUE_MAX_SIZE : length;
+        if (RN487X_WriteCharacteristicAsync(handle, payload, size, NULL) == false)
+        {
+            // RN487X command queue is full: drop the value rather than wait,
+            // and report every value again on the next tick
+            memset(reportCache, 0, sizeof(reportCache));
+            return;
+        }
+        payload += size;
+        length -= size;
+    }
+    while (length);
+}
+#endif
+
 static uint8_t LIGHTBLUE_GetButtonValue(void)
 {
     return NOT_PRESSED_STATE - PushButtonGetValue(); // This is forcing proper data for LightBlue
@@ -508,10 +1322,8 @@ static void LIGHTBLUE_SetErrorLedValue(bool value)
 
 static void LIGHTBLUE_UpdateErrorLed(void)
 {
-    RN487X_EnterCmdMode();
-    RN487X.DelayMs(CMD_MODE_DELAY_TIME);
-    RN487X_SetOutputs(bitMap);
-    RN487X_EnterDataMode();
+    // $$$, |O and --- run from the RN487X command queue, nothing waits here
+    errorLedPending = !RN487X_SetOutputsAsync(bitMap, NULL);
 }
 
 static void LIGHTBLUE_PerformAction(char id, uint8_t data)
@@ -539,7 +1351,19 @@ static void LIGHTBLUE_PerformAction(char id, uint8_t data)
             }
             break;
         case SERIAL_DATA_ID:
-            uart[UART_CDC].Write(data); // echo out the terminal for now
+            // echo out the terminal for now; user data waits for room, it is never dropped
+            uart[UART_CDC].WriteBlock(&data, sizeof(data));
+            break;
+        case ENCODING_MODE_ID:
+            // acknowledge in the current encoding, then switch
+            LIGHTBLUE_SendPacket(ENCODING_MODE_ID, &data, sizeof(data));
+            encodingMode = data & ENCODING_MODE_MASK;
+            break;
+        case LINK_STATS_ID:
+            if (data <= UART_BLE)
+            {
+                LIGHTBLUE_SendLinkStats((uart_configurations_t)data);
+            }
             break;
         default:
             break;
@@ -30,14 +30,17 @@
 /**
  \ingroup LIGHTBLUE
  \brief  Public function used for initialization of RN487X module conditions. \n
- Application configures the GPIO state & value used for the demonstration. 
+ Application configures the GPIO state & value used for the demonstration, and 
+ the BMA253 accelerometer. 
  \return void \n
  */
 void LIGHTBLUE_Initialize(void);
 /**
  \ingroup LIGHTBLUE
  \brief  Public function used to issue Temperature Sensor data to the Light Blue application \n
- This function will request temperature data from the MCP9844, format it according to the Light Blue
+ This function will request temperature data from the MCP9844 and returns without waiting
+ for the I2C bus. The read runs from the I2C1 interrupt and the packet is sent by
+ \ref LIGHTBLUE_SensorTasks once the data has arrived. The packet is formatted according to the Light Blue
  protocol requirements using 'T' for the ID, Temperature data is sent as a 16-bit hex value 
  representing the celsius value; fahrenheit is converted through the BLE application. 
  Actual Temperature value is provided as described below:
@@ -45,13 +48,18 @@ void LIGHTBLUE_Initialize(void);
  Ta vs TCrit  Ta vs TUpper   Ta vs TLower    Sign    2^7    2^6   2^5   2^4
      b7         b6              b5             b4     b3     b2    b1    b0 
      2^3        2^2             2^1           2^0    2^-1   2^-2  2^-3  2^-4
+The packet is only sent when the temperature moved more than TEMPERATURE_DEADBAND, or as
+a keep-alive after KEEP_ALIVE_TICKS samples.
  \return void \n
  */
 void LIGHTBLUE_TemperatureSensor(void);
 /**
  \ingroup LIGHTBLUE
  \brief  Public function used to issue Acceleration Sensor data to the Light Blue application \n
- This function will request X, Y, Z data from the BMA253, format it according to the Light Blue
+ This function will request X, Y, Z data from the BMA253 and returns without waiting
+ for the I2C bus. The read is issued once the BMA253 signals a new sample on INT1, it
+ runs from the I2C1 interrupt and the packet is sent by
+ \ref LIGHTBLUE_SensorTasks once the data has arrived. The packet is formatted according to the Light Blue
  protocol requirements using 'A' for the ID, data is sent as a 16-bit hex values 
  representing the signed acceleration data in 12-bit form with top 4 bits cleared to 0's.
  Actual value is provided as described below:
@@ -59,9 +67,21 @@ void LIGHTBLUE_TemperatureSensor(void);
      0      0       0       0      Sign   1g    500mg   250mg
      b7     b6      b5      b4     b3     b2    b1      b0 
     125mg   62.5mg  31.2mg  15.6mg 7.8mg  3.9mg 1.9mg  0.97mg
+The packet is only sent when an axis moved more than ACCEL_DEADBAND, or as a keep-alive
+after KEEP_ALIVE_TICKS samples.
  \return void \n
  */
 void LIGHTBLUE_AccelSensor(void);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Public function used to advance the interrupt driven sensor reads \n
+ This function queues the sensor reads requested by \ref LIGHTBLUE_TemperatureSensor and
+ \ref LIGHTBLUE_AccelSensor as a single I2C1 batch, and sends the 'T' and 'X'
+ packets once the data has arrived. It never waits on the bus and must be called
+ periodically from the application loop while CONNECTED.
+ \return void \n
+ */
+void LIGHTBLUE_SensorTasks(void);
 /**
  \ingroup LIGHTBLUE
  \brief  Public function used to issue Push button state to the Light Blue application \n
@@ -70,6 +90,7 @@ void LIGHTBLUE_AccelSensor(void);
  representing the button pressed state.
 0 - Pressed
 1- Released
+The packet is only sent when the state changed, or as a keep-alive after KEEP_ALIVE_TICKS calls.
  \return void \n
  */
 void LIGHTBLUE_PushButton(void);
@@ -84,6 +105,7 @@ status request through GPIO register on the PIC board; ERR is connected to the M
 the AVR design. 
 0 - ON
 1- OFF
+Each LED packet is only sent when its state changed, or as a keep-alive after KEEP_ALIVE_TICKS calls.
  \return void \n
  */
 void LIGHTBLUE_LedState(void);
@@ -95,6 +117,7 @@ The protocol version can be used to alter behavior, or presentation through the
  protocol format to be expected from the end-device. The packet is formated using
  the 'V' for the ID. 
 E.G. "1.0.0"
+The version is sent once per connection, see \ref LIGHTBLUE_ResetSession.
  \return void \n
  */
 void LIGHTBLUE_SendProtocolVersion(void);
@@ -104,11 +127,37 @@ void LIGHTBLUE_SendProtocolVersion(void);
 This function will receive string message via the CDC terminal when CONNECTED, 
 format it according to the Light Blue protocol requirements using 'S' for the ID, 
 data is sent represented as Character's. Serial Message entered through the 
-terminal are sent upon reception through the message parser. No interrogation of
+terminal are sent upon reception through the message parser. The lines are
+assembled by the EUSART1 receive interrupt, see EUSART1_SetLineMode(). No interrogation of
 string or data is performed by the end-device. 
  \return void \n
  */
-void LIGHTBLUE_SendSerialData(char* serialData);
+void LIGHTBLUE_SendSerialData(const char* serialData);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Public function used to restore the Light Blue session defaults \n
+This function is called when the BLE connection is lost. The payload encoding
+negotiated through the 'F' packet falls back to ASCII hex, without composite packet,
+for the next connection. The report cache is cleared, so every value and the protocol
+version are sent again after the next connection. Every tick is reported again until
+the next connection parameter update.
+ \return void \n
+ */
+void LIGHTBLUE_ResetSession(void);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Public function used to collect the packets of a timer tick into one packet \n
+When the composite encoding was selected through the 'F' packet, the sensor and IO
+packets that follow are added as records of a single 'C' packet instead of being sent
+on their own. The 'C' packet is sent by \ref LIGHTBLUE_SensorTasks once the sensor
+reads of the tick have finished. Payload of the 'C' packet:
+[ID] [Length] [Payload] ... [ID] [Length] [Payload]
+with ID the Type ID of the replaced packet and Length its number of payload bytes.
+Only 'T', 'X', 'P' and 'L' packets are carried by the 'C' packet. Does nothing in the
+other encodings.
+ \return void \n
+ */
+void LIGHTBLUE_StartTelemetryFrame(void);
 /**
  \ingroup LIGHTBLUE
  \brief  Public function used to parse message received from the Light Blue application \n
@@ -121,9 +170,27 @@ Packet ID Options:
 'L' : LEDs Status Update
 'S' : Serial Data to be bridged through CDC
 'R' : Error has occurred; LED action will be requested
+'F' : Select the payload encoding of transmitted packets; 00 ASCII hex (default),
+      01 binary with '[', ']' and '\\' escaped, 02 composite 'C' packet per tick
+      (ASCII hex), 03 composite 'C' packet per tick (binary). Acknowledged with a 'F' packet. 
+      Received packets are always ASCII hex.
+'D' : Request the link statistics of a UART; 00 CDC, 01 BLE. Answered with a 'D' packet:
+      [UART] [TX bytes] [RX bytes] [Overruns] [Framing errors] [RX dropped] [TX stalls]
+      [TX high-water] [RX high-water], counters are 16bit low byte first, high-water
+      marks are 8bit ring occupancies.
  \return void \n
  */
 void LIGHTBLUE_ParseIncomingPacket(char receivedByte);
+/**
+ \ingroup LIGHTBLUE
+ \brief  Public function used to print the UART link statistics to the CDC terminal \n
+This function prints one line per UART with the counters also carried by the 'D'
+packet, as hex values:
+CDC tx 0000 rx 0000 ovr 0000 fer 0000 drop 0000 stall 0000 hw TTRR
+with TT the transmit and RR the receive ring high-water mark.
+ \return void \n
+ */
+void LIGHTBLUE_PrintLinkStats(void);
 
 #endif	/* LIGHTBLUE_SERVICE_H */
 
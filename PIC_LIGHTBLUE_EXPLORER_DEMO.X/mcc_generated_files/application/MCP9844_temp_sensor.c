@@ -44,6 +44,17 @@ by the ambient temperature register.
 */
 #define MSB_MASK                            (0xFF00)
 
+/**
+\ingroup MCP9844
+\def TEMPERATURE_DATA_SIZE
+This is a macro for the size of the Ambient Temperature register (MSB first).
+*/
+#define TEMPERATURE_DATA_SIZE               (2)
+
+static uint8_t ambientData[TEMPERATURE_DATA_SIZE];         /**< Ambient Temperature register captured by the interrupt driven read */
+static volatile bool temperatureReadDone = false;           /**< Set from I2C1_Tasks() when the interrupt driven read has finished */
+static volatile i2c1_error_t temperatureReadError;          /**< Bus status of the last interrupt driven read */
+
 /**
  \ingroup MCP9844
  \brief \n
@@ -56,6 +67,31 @@ by the ambient temperature register.
  \retval int16_t temperatureData, Formated representation of ambient temperature
  */
 static int16_t MCP9844_CalcTemperature(void);
+/**
+ \ingroup MCP9844
+ \brief \n
+ This function is private to the source file. It clears the flag bits of the
+ raw Ambient Temperature register value.
+ \param[in] ambientRegister - raw 16-bit Ambient Temperature register value
+ \return Signed temperature value representing celsius value measured by MCP9844\n 
+ */
+static int16_t MCP9844_FormatTemperature(uint16_t ambientRegister);
+/**
+ \ingroup MCP9844
+ \brief \n
+ This function is private to the source file. It is called from I2C1_Tasks()
+ when the interrupt driven temperature read has finished.
+ \param[in] error - bus status of the finished transaction
+ \param[in] ptr - unused
+ \return void \n
+ */
+static void MCP9844_TemperatureReadComplete(i2c1_error_t error, void *ptr);
+
+static i2c1_transaction_t temperatureTransaction = {
+    MCP9844_ADDR, I2C1_CLOCK_400KHZ, MCP9844_TEMP_AMBIENT_REG, true,
+    ambientData, sizeof(ambientData),
+    MCP9844_TemperatureReadComplete, NULL
+};
 
 uint16_t MCP9844_GetManufacture(void)
 {
@@ -72,17 +108,44 @@ void MCP9844_GetTemperatureValue(int16_t *temperature)
     *temperature = MCP9844_CalcTemperature();
 }
 
+i2c1_transaction_t* MCP9844_PrepareTemperatureRead(void)
+{
+    temperatureReadDone = false;
+    return &temperatureTransaction;
+}
+
+bool MCP9844_IsTemperatureReadDone(void)
+{
+    return temperatureReadDone;
+}
+
+bool MCP9844_GetTemperatureReadValue(int16_t *temperature)
+{
+    *temperature = MCP9844_FormatTemperature(((uint16_t)ambientData[0] << 8) | ambientData[1]);
+    return (I2C1_NOERR == temperatureReadError);
+}
+
 static int16_t MCP9844_CalcTemperature(void)
+{
+    return MCP9844_FormatTemperature(i2c_read2ByteRegister(MCP9844_ADDR, MCP9844_TEMP_AMBIENT_REG));
+}
+
+static int16_t MCP9844_FormatTemperature(uint16_t ambientRegister)
 {
     int16_t temperatureData;
     uint8_t upperByte;
     uint8_t lowerByte;
     
-    temperatureData = i2c_read2ByteRegister(MCP9844_ADDR, MCP9844_TEMP_AMBIENT_REG);
-    upperByte = ((temperatureData & MSB_MASK) >> 8) & CLEAR_FLAG_BITS_MASK;
-    lowerByte = (uint8_t)temperatureData;
+    upperByte = ((ambientRegister & MSB_MASK) >> 8) & CLEAR_FLAG_BITS_MASK;
+    lowerByte = (uint8_t)ambientRegister;
     
     temperatureData = ((int16_t)(upperByte << 8) | lowerByte);
     
     return temperatureData;
-}
\ No newline at end of file
+}
+
+static void MCP9844_TemperatureReadComplete(i2c1_error_t error, void *ptr)
+{
+    temperatureReadError = error;
+    temperatureReadDone = true;
+}
@@ -28,6 +28,8 @@
 #define	MCP9844_TEMP_SENSOR_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "../i2c1_master.h"
 
 /**
 \ingroup MCP9844
@@ -128,6 +130,38 @@ uint16_t MCP9844_GetManufacture(void);
  \retval \ref uint16_t - read value from MCP9844_DEVICE_REG location \n 
  */
 uint16_t MCP9844_GetDevice(void);
+/**
+ \ingroup MCP9844
+ \brief \n
+ * This API prepares an interrupt driven read of the Ambient Temperature register
+ * and returns its I2C1 transaction descriptor, to be queued alone or as part of
+ * a batch. Completion is reported through @ref MCP9844_IsTemperatureReadDone
+ * and the value is collected with @ref MCP9844_GetTemperatureReadValue
+ \param[in] void
+ \return Transaction descriptor of the read \n
+ \retval i2c1_transaction_t* - pass to I2C1_SubmitTransaction or I2C1_SubmitBatch \n
+ */
+i2c1_transaction_t* MCP9844_PrepareTemperatureRead(void);
+/**
+ \ingroup MCP9844
+ \brief \n
+ * This API reports if the read started by @ref MCP9844_PrepareTemperatureRead
+ * has finished on the bus.
+ \param[in] void
+ \return Read completion state \n
+ \retval bool true - read finished | false - read in progress or not started \n
+ */
+bool MCP9844_IsTemperatureReadDone(void);
+/**
+ \ingroup MCP9844
+ \brief \n
+ * This API returns the Ambient Temperature captured by the last finished
+ * @ref MCP9844_PrepareTemperatureRead, formatted as @ref MCP9844_GetTemperatureValue
+ \param[in] temperature - variable used to store, and return read temperature
+ \return Status of the finished read \n
+ \retval bool true - temperature is valid | false - I2C bus error \n
+ */
+bool MCP9844_GetTemperatureReadValue(int16_t *temperature);
 
 #endif	/* MCP9844_TEMP_SENSOR_H */
 
@@ -23,4 +23,63 @@
 #ifndef BLE_EXPLORER_CONFIG_H
 #define BLE_EXPLORER_CONFIG_H
 
+#ifndef BLE_UART_FLOW_CONTROL
+/**
+ * \def BLE_UART_FLOW_CONTROL
+ * Enables RTS/CTS hardware flow control on the RN487X UART (EUSART2).
+ * Requires the RN487X RTS output wired to BT_CTS (RC2) and its CTS input
+ * wired to BT_RTS (RC3). Both lines are active low.
+ */
+#define BLE_UART_FLOW_CONTROL           (0)
+#endif
+
+#ifndef BLE_UART_RTS_MARGIN
+/**
+ * \def BLE_UART_RTS_MARGIN
+ * Number of free EUSART2 receive ring bytes left when RTS is deasserted.
+ * Covers the bytes the RN487X still sends after it sees RTS go high.
+ */
+#define BLE_UART_RTS_MARGIN             (8)
+#endif
+
+#ifndef BLE_UART_BAUD_NEGOTIATION
+/**
+ * \def BLE_UART_BAUD_NEGOTIATION
+ * Moves the RN487X UART from BLE_UART_BOOT_BAUD to BLE_UART_TARGET_BAUD at
+ * startup, falling back to BLE_UART_BOOT_BAUD if RN487X does not answer.
+ * The rate is saved by RN487X, so it is off by default.
+ */
+#define BLE_UART_BAUD_NEGOTIATION       (0)
+#endif
+
+#ifndef BLE_UART_BOOT_BAUD
+/**
+ * \def BLE_UART_BOOT_BAUD
+ * RN487X baud rate programmed by EUSART2_Initialize().
+ */
+#define BLE_UART_BOOT_BAUD              RN487X_BAUD_9600
+#endif
+
+#ifndef BLE_UART_TARGET_BAUD
+/**
+ * \def BLE_UART_TARGET_BAUD
+ * RN487X baud rate negotiated at startup. At 32 MHz the EUSART reaches 230400
+ * within 0.8%, leaving room for the internal oscillator error; 460800 is off
+ * by 2.1% and 921600 by 3.5% from the rounding alone, and are not recommended.
+ */
+#define BLE_UART_TARGET_BAUD            RN487X_BAUD_230400
+#endif
+
+#ifndef BLE_PRIVATE_SERVICE
+/**
+ * \def BLE_PRIVATE_SERVICE
+ * Replaces the Transparent UART service by a private service with one
+ * characteristic per data type. RN487X stays in command mode and each value
+ * is written with SHW, notifying the subscribed clients. The link is
+ * connected from %CONNECT%, and the CDC terminal is not bridged while
+ * disconnected.
+ */
+#define BLE_PRIVATE_SERVICE             (0)
+#endif
+
 #endif // BLE_EXPLORER_CONFIG_H
@@ -31,11 +31,35 @@
 #include "i2c_simple_master.h"
 
 /****************************************************************/
-static i2c1_operations_t wr1RegCompleteHandler(void *p)
+typedef struct
+{
+    volatile bool done;
+    i2c1_error_t error;
+}request_t;
+
+static void requestCompleteHandler(i2c1_error_t error, void *p)
+{
+    ((request_t *)p)->error = error;
+    ((request_t *)p)->done = true;
+}
+
+// Queue a single register transaction and wait for it to finish
+static i2c1_error_t i2c_registerTransaction(i2c1_address_t address, uint8_t reg, bool read, void *data, size_t len)
 {
-    I2C1_SetBuffer(p,1);
-    I2C1_SetDataCompleteCallback(NULL,NULL);
-    return I2C1_CONTINUE;
+    request_t request = {false, I2C1_NOERR};
+    i2c1_transaction_t transaction = {address, I2C1_GetClock(), reg, read, data, len, requestCompleteHandler, &request};
+
+    while(I2C1_NOERR != I2C1_SubmitTransaction(&transaction)) // sit here until it is queued..
+    {
+        I2C1_Poll();
+        I2C1_Tasks();
+    }
+    while(!request.done) // sit here until finished, or timed out by I2C1_Tasks()
+    {
+        I2C1_Poll();
+        I2C1_Tasks();
+    }
+    return request.error;
 }
 
 /**
@@ -50,12 +74,7 @@ static i2c1_operations_t wr1RegCompleteHandler(void *p)
  */
 void i2c_write1ByteRegister(i2c1_address_t address, uint8_t reg, uint8_t data)
 {
-    while(!I2C1_Open(address)); // sit here until we get the bus..
-    I2C1_SetDataCompleteCallback(wr1RegCompleteHandler,&data);
-    I2C1_SetBuffer(&reg,1);
-    I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
-    I2C1_MasterWrite();
-    while(I2C1_BUSY == I2C1_Close()); // sit here until finished.
+    i2c_registerTransaction(address, reg, false, &data, 1);
 }
 
 /**
@@ -70,7 +89,7 @@ void i2c_write1ByteRegister(i2c1_address_t address, uint8_t reg, uint8_t data)
  */
 void i2c_writeNBytes(i2c1_address_t address, void* data, size_t len)
 {
-    while(!I2C1_Open(address)); // sit here until we get the bus..
+    while(I2C1_NOERR != I2C1_Open(address)); // sit here until we get the bus..
     I2C1_SetBuffer(data,len);
     I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
     I2C1_MasterWrite();
@@ -78,13 +97,6 @@ void i2c_writeNBytes(i2c1_address_t address, void* data, size_t len)
 }
 
 /****************************************************************/
-static i2c1_operations_t rd1RegCompleteHandler(void *p)
-{
-    I2C1_SetBuffer(p,1);
-    I2C1_SetDataCompleteCallback(NULL,NULL);
-    return I2C1_RESTART_READ;
-}
-
 /**
  *  \ingroup doc_driver_i2c_code
  *  \brief Function to read 1 byte of data from a register location
@@ -97,32 +109,18 @@ static i2c1_operations_t rd1RegCompleteHandler(void *p)
 uint8_t i2c_read1ByteRegister(i2c1_address_t address, uint8_t reg)
 {
     uint8_t    d2=42;
-    i2c1_error_t e;
     int x;
 
     for(x = 2; x != 0; x--)
     {
-        while(!I2C1_Open(address)); // sit here until we get the bus..
-        I2C1_SetDataCompleteCallback(rd1RegCompleteHandler,&d2);
-        I2C1_SetBuffer(&reg,1);
-        I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
-        I2C1_MasterWrite();
-        while(I2C1_BUSY == (e = I2C1_Close())); // sit here until finished.
-        if(e==I2C1_NOERR) break;
+        if(I2C1_NOERR == i2c_registerTransaction(address, reg, true, &d2, 1)) break;
     }
-    
+
 
     return d2;
 }
 
 /****************************************************************/
-static i2c1_operations_t rd2RegCompleteHandler(void *p)
-{
-    I2C1_SetBuffer(p,2);
-    I2C1_SetDataCompleteCallback(NULL,NULL);
-    return I2C1_RESTART_READ;
-}
-
 /**
  *  \ingroup doc_driver_i2c_code
  *  \brief Function to read 2 byte of data from a register location
@@ -137,24 +135,12 @@ uint16_t i2c_read2ByteRegister(i2c1_address_t address, uint8_t reg)
     // result is little endian
     uint16_t    result;
 
-    while(!I2C1_Open(address)); // sit here until we get the bus..
-    I2C1_SetDataCompleteCallback(rd2RegCompleteHandler,&result);
-    I2C1_SetBuffer(&reg,1);
-    I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
-    I2C1_MasterWrite();
-    while(I2C1_BUSY == I2C1_Close()); // sit here until finished.
-    
+    i2c_registerTransaction(address, reg, true, &result, 2);
+
     return (result << 8 | result >> 8);
 }
 
 /****************************************************************/
-static i2c1_operations_t wr2RegCompleteHandler(void *p)
-{
-    I2C1_SetBuffer(p,2);
-    I2C1_SetDataCompleteCallback(NULL,NULL);
-    return I2C1_CONTINUE;
-}
-
 /**
  *  \ingroup doc_driver_i2c_code
  *  \brief Function to write 1 byte of data to a register location
@@ -167,28 +153,10 @@ static i2c1_operations_t wr2RegCompleteHandler(void *p)
  */
 void i2c_write2ByteRegister(i2c1_address_t address, uint8_t reg, uint16_t data)
 {
-    while(!I2C1_Open(address)); // sit here until we get the bus..
-    I2C1_SetDataCompleteCallback(wr2RegCompleteHandler,&data);
-    I2C1_SetBuffer(&reg,1);
-    I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
-    I2C1_MasterWrite();
-    while(I2C1_BUSY == I2C1_Close()); // sit here until finished.
+    i2c_registerTransaction(address, reg, false, &data, 2);
 }
 
 /****************************************************************/
-typedef struct
-{
-    size_t len;
-    char *data;
-}buf_t;
-
-static i2c1_operations_t rdBlkRegCompleteHandler(void *p)
-{
-    I2C1_SetBuffer(((buf_t *)p)->data,((buf_t*)p)->len);
-    I2C1_SetDataCompleteCallback(NULL,NULL);
-    return I2C1_RESTART_READ;
-}
-
 /**
  *  \ingroup doc_driver_i2c_code
  *  \brief Function to read block of data from a register location
@@ -202,17 +170,7 @@ static i2c1_operations_t rdBlkRegCompleteHandler(void *p)
  */
 void i2c_readDataBlock(i2c1_address_t address, uint8_t reg, void *data, size_t len)
 {
-    // result is little endian
-    buf_t    d;
-    d.data = data;
-    d.len = len;
-
-    while(!I2C1_Open(address)); // sit here until we get the bus..
-    I2C1_SetDataCompleteCallback(rdBlkRegCompleteHandler,&d);
-    I2C1_SetBuffer(&reg,1);
-    I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
-    I2C1_MasterWrite();
-    while(I2C1_BUSY == I2C1_Close()); // sit here until finished.
+    i2c_registerTransaction(address, reg, true, data, len);
 }
 
 /**
@@ -227,7 +185,7 @@ void i2c_readDataBlock(i2c1_address_t address, uint8_t reg, void *data, size_t l
  */
 void i2c_readNBytes(i2c1_address_t address, void *data, size_t len)
 {
-    while(!I2C1_Open(address)); // sit here until we get the bus..
+    while(I2C1_NOERR != I2C1_Open(address)); // sit here until we get the bus..
     I2C1_SetBuffer(data,len);
     I2C1_MasterRead();
     while(I2C1_BUSY == I2C1_Close()); // sit here until finished.
@@ -33,8 +33,8 @@
 
 
 const uart_functions_t uart[] = {   
-    {EUSART1_Read, EUSART1_Write, EUSART1_is_tx_ready, EUSART1_is_rx_ready, EUSART1_SetTxInterruptHandler, EUSART1_Receive_ISR, EUSART1_SetRxInterruptHandler, EUSART1_is_tx_done, EUSART1_Transmit_ISR, EUSART1_Initialize },
-    {EUSART2_Read, EUSART2_Write, EUSART2_is_tx_ready, EUSART2_is_rx_ready, EUSART2_SetTxInterruptHandler, EUSART2_Receive_ISR, EUSART2_SetRxInterruptHandler, EUSART2_is_tx_done, EUSART2_Transmit_ISR, EUSART2_Initialize }
+    {EUSART1_Read, EUSART1_Write, EUSART1_is_tx_ready, EUSART1_is_rx_ready, EUSART1_SetTxInterruptHandler, EUSART1_Receive_ISR, EUSART1_SetRxInterruptHandler, EUSART1_is_tx_done, EUSART1_Transmit_ISR, EUSART1_Initialize, EUSART1_WriteBlock, EUSART1_ReadBlock, EUSART1_TryWriteBlock, EUSART1_GetTxSpace, EUSART1_SetTxDrainedHandler, EUSART1_SetBaudDivisor, EUSART1_GetCounters, EUSART1_ResetCounters, EUSART1_IsRxIdle, EUSART1_ReadTimeout },
+    {EUSART2_Read, EUSART2_Write, EUSART2_is_tx_ready, EUSART2_is_rx_ready, EUSART2_SetTxInterruptHandler, EUSART2_Receive_ISR, EUSART2_SetRxInterruptHandler, EUSART2_is_tx_done, EUSART2_Transmit_ISR, EUSART2_Initialize, EUSART2_WriteBlock, EUSART2_ReadBlock, EUSART2_TryWriteBlock, EUSART2_GetTxSpace, EUSART2_SetTxDrainedHandler, EUSART2_SetBaudDivisor, EUSART2_GetCounters, EUSART2_ResetCounters, EUSART2_IsRxIdle, EUSART2_ReadTimeout }
 };
 
 /**
@@ -48,7 +48,7 @@ typedef enum {
 *   \ingroup doc_driver_uart_code
 *   \struct uart_functions_t uart.h
 */
-typedef struct { uint8_t (*Read)(void); void (*Write)(uint8_t txdata); bool (*TransmitReady)(void); bool (*DataReady)(void); void (*SetTxISR)(void (* interruptHandler)(void)); void (*RxDefaultISR)(void); void (*SetRxISR)(void (* interruptHandler)(void)); bool (*TransmitDone)(void); void (*TxDefaultISR)(void); void (*Initialize)(void);  } uart_functions_t;
+typedef struct { uint8_t (*Read)(void); void (*Write)(uint8_t txdata); bool (*TransmitReady)(void); bool (*DataReady)(void); void (*SetTxISR)(void (* interruptHandler)(void)); void (*RxDefaultISR)(void); void (*SetRxISR)(void (* interruptHandler)(void)); bool (*TransmitDone)(void); void (*TxDefaultISR)(void); void (*Initialize)(void); void (*WriteBlock)(const uint8_t *txData, uint8_t length); uint8_t (*ReadBlock)(uint8_t *rxData, uint8_t maxLength); uint8_t (*TryWriteBlock)(const uint8_t *txData, uint8_t length); uint8_t (*TxSpace)(void); void (*SetTxDrainedISR)(void (* interruptHandler)(void)); bool (*SetBaudDivisor)(uint16_t divisor); void (*GetCounters)(eusart_counters_t *counters); void (*ResetCounters)(void); bool (*IsRxIdle)(void); bool (*ReadTimeout)(uint8_t *rxData, uint16_t timeout);  } uart_functions_t;
 
 extern const uart_functions_t uart[];
 
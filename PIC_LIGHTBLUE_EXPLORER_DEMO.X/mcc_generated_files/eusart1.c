@@ -47,14 +47,40 @@
 /**
   Section: Included Files
 */
+#include <string.h>
 #include "eusart1.h"
+#include "tmr0.h"
 
 /**
   Section: Macro Declarations
 */
 
-#define EUSART1_TX_BUFFER_SIZE 8
-#define EUSART1_RX_BUFFER_SIZE 8
+#ifndef EUSART1_TX_BUFFER_SIZE
+#define EUSART1_TX_BUFFER_SIZE 32
+#endif
+#ifndef EUSART1_IDLE_CHARACTERS
+#define EUSART1_IDLE_CHARACTERS 4
+#endif
+#ifndef EUSART1_RX_BUFFER_SIZE
+#define EUSART1_RX_BUFFER_SIZE 16
+#endif
+#ifndef EUSART1_LINE_SIZE
+#define EUSART1_LINE_SIZE 80
+#endif
+
+#if (EUSART1_TX_BUFFER_SIZE < 2) || (EUSART1_TX_BUFFER_SIZE > 128) || (EUSART1_TX_BUFFER_SIZE & (EUSART1_TX_BUFFER_SIZE - 1))
+#error "EUSART1_TX_BUFFER_SIZE must be a power of two between 2 and 128"
+#endif
+#if (EUSART1_RX_BUFFER_SIZE < 2) || (EUSART1_RX_BUFFER_SIZE > 128) || (EUSART1_RX_BUFFER_SIZE & (EUSART1_RX_BUFFER_SIZE - 1))
+#error "EUSART1_RX_BUFFER_SIZE must be a power of two between 2 and 128"
+#endif
+
+#if (EUSART1_LINE_SIZE < 2) || (EUSART1_LINE_SIZE > 255)
+#error "EUSART1_LINE_SIZE must be between 2 and 255"
+#endif
+
+#define EUSART1_TX_BUFFER_MASK (EUSART1_TX_BUFFER_SIZE - 1)
+#define EUSART1_RX_BUFFER_MASK (EUSART1_RX_BUFFER_SIZE - 1)
 
 /**
   Section: Global Variables
@@ -71,6 +97,21 @@ volatile eusart1_status_t eusart1RxStatusBuffer[EUSART1_RX_BUFFER_SIZE];
 volatile uint8_t eusart1RxCount;
 volatile eusart1_status_t eusart1RxLastError;
 
+volatile eusart_counters_t eusart1Counters;
+
+// idle gap: TMR0 time of the last received byte, cleared once the line went quiet
+volatile uint16_t eusart1RxStamp;
+volatile bool eusart1RxActive = false;
+uint8_t eusart1IdleCharacters = EUSART1_IDLE_CHARACTERS;
+uint16_t eusart1IdleTicks;
+
+// line mode: the ISR fills one line buffer while the main loop reads the other
+char eusart1LineBuffer[2][EUSART1_LINE_SIZE];
+volatile bool eusart1LineMode = false;
+volatile bool eusart1LineReady = false;
+volatile uint8_t eusart1LineFill = 0;
+volatile uint8_t eusart1LineLength = 0;
+
 /**
   Section: EUSART1 APIs
 */
@@ -80,10 +121,15 @@ void (*EUSART1_RxDefaultInterruptHandler)(void);
 void (*EUSART1_FramingErrorHandler)(void);
 void (*EUSART1_OverrunErrorHandler)(void);
 void (*EUSART1_ErrorHandler)(void);
+void (*EUSART1_TxDrainedHandler)(void);
 
 void EUSART1_DefaultFramingErrorHandler(void);
 void EUSART1_DefaultOverrunErrorHandler(void);
 void EUSART1_DefaultErrorHandler(void);
+void EUSART1_DefaultTxDrainedHandler(void);
+
+static void EUSART1_UpdateIdleTicks(void);
+static void EUSART1_CompleteLine(void);
 
 void EUSART1_Initialize(void)
 {
@@ -109,10 +155,12 @@ void EUSART1_Initialize(void)
     // SP1BRGH 3; 
     SP1BRGH = 0x03;
 
+    EUSART1_UpdateIdleTicks();
 
     EUSART1_SetFramingErrorHandler(EUSART1_DefaultFramingErrorHandler);
     EUSART1_SetOverrunErrorHandler(EUSART1_DefaultOverrunErrorHandler);
     EUSART1_SetErrorHandler(EUSART1_DefaultErrorHandler);
+    EUSART1_SetTxDrainedHandler(EUSART1_DefaultTxDrainedHandler);
 
     eusart1RxLastError.status = 0;
 
@@ -125,6 +173,8 @@ void EUSART1_Initialize(void)
     eusart1RxTail = 0;
     eusart1RxCount = 0;
 
+    memset((void *)&eusart1Counters, 0, sizeof(eusart1Counters));
+
     // enable receive interrupt
     PIE3bits.RC1IE = 1;
 }
@@ -158,11 +208,8 @@ uint8_t EUSART1_Read(void)
 
     eusart1RxLastError = eusart1RxStatusBuffer[eusart1RxTail];
 
-    readValue = eusart1RxBuffer[eusart1RxTail++];
-    if(sizeof(eusart1RxBuffer) <= eusart1RxTail)
-    {
-        eusart1RxTail = 0;
-    }
+    readValue = eusart1RxBuffer[eusart1RxTail];
+    eusart1RxTail = (eusart1RxTail + 1) & EUSART1_RX_BUFFER_MASK;
     PIE3bits.RC1IE = 0;
     eusart1RxCount--;
     PIE3bits.RC1IE = 1;
@@ -172,6 +219,10 @@ uint8_t EUSART1_Read(void)
 
 void EUSART1_Write(uint8_t txData)
 {
+    if(0 == eusart1TxBufferRemaining)
+    {
+        eusart1Counters.txStalls++;
+    }
     while(0 == eusart1TxBufferRemaining)
     {
     }
@@ -179,16 +230,18 @@ void EUSART1_Write(uint8_t txData)
     if(0 == PIE3bits.TX1IE)
     {
         TX1REG = txData;
+        eusart1Counters.txBytes++;
     }
     else
     {
         PIE3bits.TX1IE = 0;
-        eusart1TxBuffer[eusart1TxHead++] = txData;
-        if(sizeof(eusart1TxBuffer) <= eusart1TxHead)
+        eusart1TxBuffer[eusart1TxHead] = txData;
+        eusart1TxHead = (eusart1TxHead + 1) & EUSART1_TX_BUFFER_MASK;
+        eusart1TxBufferRemaining--;
+        if((EUSART1_TX_BUFFER_SIZE - eusart1TxBufferRemaining) > eusart1Counters.txHighWater)
         {
-            eusart1TxHead = 0;
+            eusart1Counters.txHighWater = EUSART1_TX_BUFFER_SIZE - eusart1TxBufferRemaining;
         }
-        eusart1TxBufferRemaining--;
     }
     PIE3bits.TX1IE = 1;
 }
@@ -203,41 +256,116 @@ void putch(char txData)
     EUSART1_Write(txData);
 }
 
+uint8_t EUSART1_ReadBlock(uint8_t *rxData, uint8_t maxLength)
+{
+    uint8_t count;
+    uint8_t index;
+
+    PIE3bits.RC1IE = 0;
+    count = (eusart1RxCount < maxLength) ? eusart1RxCount : maxLength;
+    for(index = 0; index < count; index++)
+    {
+        eusart1RxLastError = eusart1RxStatusBuffer[eusart1RxTail];
+        rxData[index] = eusart1RxBuffer[eusart1RxTail];
+        eusart1RxTail = (eusart1RxTail + 1) & EUSART1_RX_BUFFER_MASK;
+    }
+    eusart1RxCount -= count;
+    PIE3bits.RC1IE = 1;
+
+    return count;
+}
+
+uint8_t EUSART1_GetTxSpace(void)
+{
+    return eusart1TxBufferRemaining;
+}
+
+uint8_t EUSART1_TryWriteBlock(const uint8_t *txData, uint8_t length)
+{
+    uint8_t count;
+    uint8_t index;
+
+    PIE3bits.TX1IE = 0;
+    count = (eusart1TxBufferRemaining < length) ? eusart1TxBufferRemaining : length;
+    for(index = 0; index < count; index++)
+    {
+        eusart1TxBuffer[eusart1TxHead] = txData[index];
+        eusart1TxHead = (eusart1TxHead + 1) & EUSART1_TX_BUFFER_MASK;
+    }
+    eusart1TxBufferRemaining -= count;
+    if((EUSART1_TX_BUFFER_SIZE - eusart1TxBufferRemaining) > eusart1Counters.txHighWater)
+    {
+        eusart1Counters.txHighWater = EUSART1_TX_BUFFER_SIZE - eusart1TxBufferRemaining;
+    }
+    PIE3bits.TX1IE = (EUSART1_TX_BUFFER_SIZE > eusart1TxBufferRemaining);
+
+    return count;
+}
+
+void EUSART1_WriteBlock(const uint8_t *txData, uint8_t length)
+{
+    uint8_t count;
+
+    while(length)
+    {
+        if(0 == eusart1TxBufferRemaining)
+        {
+            eusart1Counters.txStalls++;
+        }
+        while(0 == eusart1TxBufferRemaining)
+        {
+        }
+
+        count = EUSART1_TryWriteBlock(txData, length);
+        txData += count;
+        length -= count;
+    }
+}
+
+
 void EUSART1_Transmit_ISR(void)
 {
 
     // add your EUSART1 interrupt custom code
     if(sizeof(eusart1TxBuffer) > eusart1TxBufferRemaining)
     {
-        TX1REG = eusart1TxBuffer[eusart1TxTail++];
-        if(sizeof(eusart1TxBuffer) <= eusart1TxTail)
-        {
-            eusart1TxTail = 0;
-        }
+        TX1REG = eusart1TxBuffer[eusart1TxTail];
+        eusart1Counters.txBytes++;
+        eusart1TxTail = (eusart1TxTail + 1) & EUSART1_TX_BUFFER_MASK;
         eusart1TxBufferRemaining++;
     }
     else
     {
         PIE3bits.TX1IE = 0;
+        EUSART1_TxDrainedHandler();
     }
 }
 
 void EUSART1_Receive_ISR(void)
 {
-    
-    eusart1RxStatusBuffer[eusart1RxHead].status = 0;
+    eusart1_status_t rxStatus;
+
+    rxStatus.status = 0;
 
     if(RC1STAbits.FERR){
-        eusart1RxStatusBuffer[eusart1RxHead].ferr = 1;
+        rxStatus.ferr = 1;
+        eusart1Counters.framingErrors++;
         EUSART1_FramingErrorHandler();
     }
 
     if(RC1STAbits.OERR){
-        eusart1RxStatusBuffer[eusart1RxHead].oerr = 1;
+        rxStatus.oerr = 1;
+        eusart1Counters.overrunErrors++;
         EUSART1_OverrunErrorHandler();
     }
-    
-    if(eusart1RxStatusBuffer[eusart1RxHead].status){
+
+    // a full ring drops the byte - keep the status of the oldest unread
+    // byte and leave the error in the counters only
+    if(EUSART1_RX_BUFFER_SIZE > eusart1RxCount){
+        eusart1RxStatusBuffer[eusart1RxHead] = rxStatus;
+    }
+
+    if(rxStatus.status){
         EUSART1_ErrorHandler();
     } else {
         EUSART1_RxDataHandler();
@@ -248,12 +376,136 @@ void EUSART1_Receive_ISR(void)
 
 void EUSART1_RxDataHandler(void){
     // use this default receive interrupt handler code
-    eusart1RxBuffer[eusart1RxHead++] = RC1REG;
-    if(sizeof(eusart1RxBuffer) <= eusart1RxHead)
+    uint8_t rxData = RC1REG;
+
+    eusart1Counters.rxBytes++;
+    eusart1RxStamp = TMR0_ReadTimer();
+    eusart1RxActive = true;
+    if(eusart1LineMode)
     {
-        eusart1RxHead = 0;
+        if(('\r' == rxData) || ('\n' == rxData))
+        {
+            if(0 == eusart1LineLength)
+            {
+                // empty line, or the LF of a CR LF pair
+                return;
+            }
+        }
+        else
+        {
+            eusart1LineBuffer[eusart1LineFill][eusart1LineLength++] = rxData;
+            if((EUSART1_LINE_SIZE - 1) > eusart1LineLength)
+            {
+                return;
+            }
+        }
+        if(eusart1LineReady)
+        {
+            // previous line not taken yet - drop this one
+            eusart1Counters.rxDropped += eusart1LineLength;
+            eusart1LineLength = 0;
+            return;
+        }
+        EUSART1_CompleteLine();
+        return;
+    }
+    if(EUSART1_RX_BUFFER_SIZE <= eusart1RxCount)
+    {
+        // ring full - drop the byte rather than overwrite unread data
+        eusart1Counters.rxDropped++;
+        return;
     }
+    eusart1RxBuffer[eusart1RxHead] = rxData;
+    eusart1RxHead = (eusart1RxHead + 1) & EUSART1_RX_BUFFER_MASK;
     eusart1RxCount++;
+    if(eusart1RxCount > eusart1Counters.rxHighWater)
+    {
+        eusart1Counters.rxHighWater = eusart1RxCount;
+    }
+}
+
+uint8_t EUSART1_GetTxHighWater(void)
+{
+    return eusart1Counters.txHighWater;
+}
+
+uint8_t EUSART1_GetRxHighWater(void)
+{
+    return eusart1Counters.rxHighWater;
+}
+
+void EUSART1_ResetHighWater(void)
+{
+    PIE3bits.TX1IE = 0;
+    PIE3bits.RC1IE = 0;
+    eusart1Counters.txHighWater = EUSART1_TX_BUFFER_SIZE - eusart1TxBufferRemaining;
+    eusart1Counters.rxHighWater = eusart1RxCount;
+    PIE3bits.RC1IE = 1;
+    PIE3bits.TX1IE = (EUSART1_TX_BUFFER_SIZE > eusart1TxBufferRemaining);
+}
+
+void EUSART1_GetCounters(eusart_counters_t *counters)
+{
+    bool txState = PIE3bits.TX1IE;
+
+    PIE3bits.TX1IE = 0;
+    PIE3bits.RC1IE = 0;
+    *counters = eusart1Counters;
+    PIE3bits.RC1IE = 1;
+    PIE3bits.TX1IE = txState;
+}
+
+void EUSART1_ResetCounters(void)
+{
+    bool txState = PIE3bits.TX1IE;
+
+    PIE3bits.TX1IE = 0;
+    PIE3bits.RC1IE = 0;
+    memset((void *)&eusart1Counters, 0, sizeof(eusart1Counters));
+    eusart1Counters.txHighWater = EUSART1_TX_BUFFER_SIZE - eusart1TxBufferRemaining;
+    eusart1Counters.rxHighWater = eusart1RxCount;
+    PIE3bits.RC1IE = 1;
+    PIE3bits.TX1IE = txState;
+}
+
+void EUSART1_SetLineMode(bool enable)
+{
+    if(enable == eusart1LineMode)
+    {
+        return;
+    }
+
+    PIE3bits.RC1IE = 0;
+    eusart1LineMode = enable;
+    eusart1LineReady = false;
+    eusart1LineLength = 0;
+    // bytes received in the other mode are stale
+    eusart1RxHead = 0;
+    eusart1RxTail = 0;
+    eusart1RxCount = 0;
+    PIE3bits.RC1IE = 1;
+}
+
+const char *EUSART1_GetLine(void)
+{
+    if(!eusart1LineReady && (0 != eusart1LineLength) && EUSART1_IsRxIdle())
+    {
+        // the sender went quiet without ending the line
+        PIE3bits.RC1IE = 0;
+        EUSART1_CompleteLine();
+        PIE3bits.RC1IE = 1;
+    }
+    if(!eusart1LineReady)
+    {
+        return NULL;
+    }
+    // eusart1LineFill only changes while no line is ready
+    return eusart1LineBuffer[eusart1LineFill ^ 1];
+}
+
+void EUSART1_ReleaseLine(void)
+{
+    eusart1LineReady = false;
 }
 
 void EUSART1_DefaultFramingErrorHandler(void){}
@@ -270,6 +522,8 @@ void EUSART1_DefaultErrorHandler(void){
     EUSART1_RxDataHandler();
 }
 
+void EUSART1_DefaultTxDrainedHandler(void){}
+
 void EUSART1_SetFramingErrorHandler(void (* interruptHandler)(void)){
     EUSART1_FramingErrorHandler = interruptHandler;
 }
@@ -282,6 +536,90 @@ void EUSART1_SetErrorHandler(void (* interruptHandler)(void)){
     EUSART1_ErrorHandler = interruptHandler;
 }
 
+bool EUSART1_SetBaudDivisor(uint16_t divisor){
+    uint32_t limit = (uint32_t)EUSART1_DRAIN_TIMEOUT * TMR0_TICK_FREQUENCY / 1000;
+    uint32_t elapsed = 0;
+    uint16_t last = TMR0_ReadTimestamp();
+    uint16_t now;
+
+    while((EUSART1_TX_BUFFER_SIZE != eusart1TxBufferRemaining) || (0 == TX1STAbits.TRMT))
+    {
+        now = TMR0_ReadTimestamp();
+        elapsed += (uint16_t)(now - last);
+        last = now;
+        if(elapsed >= limit)
+        {
+            return false;
+        }
+    }
+
+    SP1BRGL = (uint8_t)divisor;
+    SP1BRGH = (uint8_t)(divisor >> 8);
+    EUSART1_UpdateIdleTicks();
+    return true;
+}
+
+void EUSART1_SetIdleCharacters(uint8_t characters){
+    eusart1IdleCharacters = characters;
+    EUSART1_UpdateIdleTicks();
+}
+
+bool EUSART1_IsRxIdle(void){
+    bool state = INTCONbits.GIE;
+    bool idle;
+
+    // TMR0 is also read by the receive interrupts, keep its high byte latch ours
+    INTCONbits.GIE = 0;
+    if(eusart1RxActive && ((uint16_t)(TMR0_ReadTimer() - eusart1RxStamp) >= eusart1IdleTicks))
+    {
+        eusart1RxActive = false;
+    }
+    idle = !eusart1RxActive;
+    INTCONbits.GIE = state;
+
+    return idle;
+}
+
+bool EUSART1_ReadTimeout(uint8_t *rxData, uint16_t timeout){
+    uint32_t limit = (uint32_t)timeout * TMR0_TICK_FREQUENCY / 1000;
+    uint32_t elapsed = 0;
+    uint16_t last = TMR0_ReadTimestamp();
+    uint16_t now;
+
+    while(0 == eusart1RxCount)
+    {
+        now = TMR0_ReadTimestamp();
+        elapsed += (uint16_t)(now - last);
+        last = now;
+        if(elapsed >= limit)
+        {
+            return false;
+        }
+    }
+
+    *rxData = EUSART1_Read();
+    return true;
+}
+
+static void EUSART1_CompleteLine(void){
+    eusart1LineBuffer[eusart1LineFill][eusart1LineLength] = '\0';
+    eusart1LineFill ^= 1;
+    eusart1LineLength = 0;
+    eusart1LineReady = true;
+}
+
+static void EUSART1_UpdateIdleTicks(void){
+    uint16_t divisor = ((uint16_t)SP1BRGH << 8) | SP1BRGL;
+    // (10) bit times per character, SP1BRG + 1 FOSC/4 clocks per bit time
+    uint32_t ticks = ((uint32_t)eusart1IdleCharacters * 10 * ((uint32_t)divisor + 1) + (TMR0_PRESCALER - 1)) / TMR0_PRESCALER;
+
+    eusart1IdleTicks = (ticks > UINT16_MAX) ? UINT16_MAX : (uint16_t)ticks;
+}
+
+void EUSART1_SetTxDrainedHandler(void (* interruptHandler)(void)){
+    EUSART1_TxDrainedHandler = interruptHandler;
+}
+
 void EUSART1_SetTxInterruptHandler(void (* interruptHandler)(void)){
     EUSART1_TxDefaultInterruptHandler = interruptHandler;
 }
@@ -55,6 +55,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "eusart_counters.h"
 
 #ifdef __cplusplus  // Provide C++ Compatibility
 
@@ -69,6 +70,24 @@
 
 #define EUSART1_DataReady  (EUSART1_is_rx_ready())
 
+/**
+  @Summary
+    Baud rate generator value for a baud rate
+
+  @Description
+    Rounded SP1BRG value for the 16-bit, high speed generator (BRG16 = 1,
+    BRGH = 1) used by EUSART1_Initialize(). The achieved rate is
+    _XTAL_FREQ / (4 * (divisor + 1)).
+*/
+#define EUSART1_BAUD_DIVISOR(baud) ((uint16_t)((((_XTAL_FREQ) + (2UL * (baud))) / (4UL * (baud))) - 1))
+
+/**
+  @Description
+    Longest time, in milliseconds, EUSART1_SetBaudDivisor() waits for the
+    queued bytes to be shifted out. Covers a full transmit buffer at 9600 baud.
+*/
+#define EUSART1_DRAIN_TIMEOUT (100)
+
 /**
   Section: Data Type Definitions
 */
@@ -348,6 +367,342 @@ uint8_t EUSART1_Read(void);
 */
 void EUSART1_Write(uint8_t txData);
 
+/**
+  @Summary
+    Reads a block of received data from the EUSART1.
+
+  @Description
+    This routine copies up to maxLength bytes that are already waiting in the
+    EUSART1 receive ring into rxData. The receive interrupt is masked once for
+    the whole block. It does not wait for data to arrive.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    rxData    - Buffer receiving the data
+    maxLength - Size of rxData in bytes
+
+  @Returns
+    Number of bytes copied into rxData.
+*/
+uint8_t EUSART1_ReadBlock(uint8_t *rxData, uint8_t maxLength);
+
+/**
+  @Summary
+    Writes a block of data to the EUSART1.
+
+  @Description
+    This routine copies length bytes into the EUSART1 transmit ring, masking
+    the transmit interrupt once per copied chunk rather than once per byte.
+    It waits for free space when the block is larger than the ring.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    txData - Data to write to the EUSART1
+    length - Number of bytes to write
+
+  @Returns
+    None
+*/
+void EUSART1_WriteBlock(const uint8_t *txData, uint8_t length);
+
+/**
+  @Summary
+    Writes as much of a block of data to the EUSART1 as fits without waiting.
+
+  @Description
+    This routine copies up to length bytes into the free space of the EUSART1
+    transmit ring and returns immediately. The bytes that were not accepted
+    are left to the caller.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    txData - Data to write to the EUSART1
+    length - Number of bytes to write
+
+  @Returns
+    Number of bytes accepted into the transmit ring.
+*/
+uint8_t EUSART1_TryWriteBlock(const uint8_t *txData, uint8_t length);
+
+/**
+  @Summary
+    Returns the free space of the EUSART1 transmit ring.
+
+  @Description
+    This routine returns how many bytes EUSART1_TryWriteBlock() can currently
+    accept without dropping any.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    Number of free bytes in the transmit ring.
+*/
+uint8_t EUSART1_GetTxSpace(void);
+
+/**
+  @Summary
+    Returns the peak transmit ring occupancy.
+
+  @Description
+    This routine returns the largest number of bytes that have been queued
+    in the EUSART1 transmit ring since initialization or the last call to
+    EUSART1_ResetHighWater(). A value equal to EUSART1_TX_BUFFER_SIZE means
+    EUSART1_Write() has had to wait for free space.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    Peak number of bytes held in the transmit ring.
+*/
+uint8_t EUSART1_GetTxHighWater(void);
+
+/**
+  @Summary
+    Returns the peak receive ring occupancy.
+
+  @Description
+    This routine returns the largest number of unread bytes that have been
+    held in the EUSART1 receive ring since initialization or the last call to
+    EUSART1_ResetHighWater(). A value equal to EUSART1_RX_BUFFER_SIZE means
+    received bytes may have been dropped.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    Peak number of bytes held in the receive ring.
+*/
+uint8_t EUSART1_GetRxHighWater(void);
+
+/**
+  @Summary
+    Restarts the ring high-water-mark measurement.
+
+  @Description
+    This routine resets both high-water marks to the current ring occupancy.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    None
+*/
+void EUSART1_ResetHighWater(void);
+
+/**
+  @Summary
+    Reads the EUSART1 traffic and error counters.
+
+  @Description
+    This routine copies the byte, error, drop and stall counters and the
+    ring high-water marks accumulated since initialization or the last call
+    to EUSART1_ResetCounters(). The 16-bit counters wrap around.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    counters - Structure receiving the counters
+
+  @Returns
+    None
+*/
+void EUSART1_GetCounters(eusart_counters_t *counters);
+
+/**
+  @Summary
+    Clears the EUSART1 traffic and error counters.
+
+  @Description
+    This routine clears every counter and restarts the high-water marks from
+    the current ring occupancy.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    None
+*/
+void EUSART1_ResetCounters(void);
+
+/**
+  @Summary
+    Sets the EUSART1 receive idle gap.
+
+  @Description
+    The receive line is idle once no character was received for the given
+    number of character times, at the current baud rate. The gap is measured
+    with TMR0 and is limited to one TMR0 period, about 1 s. The default is
+    EUSART1_IDLE_CHARACTERS.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    characters - Idle gap in character times
+
+  @Returns
+    None
+*/
+void EUSART1_SetIdleCharacters(uint8_t characters);
+
+/**
+  @Summary
+    Checks for the end of a received burst.
+
+  @Description
+    This routine returns true once the idle gap has elapsed since the last
+    received character, marking the end of a burst of data. It should be
+    polled at least once per TMR0 period while data is received, as a longer
+    gap may appear shorter once the 16-bit timer wrapped.
+
+  @Preconditions
+    EUSART1_Initialize() and TMR0_Initialize() functions should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    true  - No character received during the idle gap
+    false - A burst is in progress
+*/
+bool EUSART1_IsRxIdle(void);
+
+/**
+  @Summary
+    Read a byte of data from the EUSART1, waiting at most the given time.
+
+  @Description
+    This routine returns the next received byte, like EUSART1_Read(), but
+    gives up if no byte arrives within the timeout.
+
+  @Preconditions
+    EUSART1_Initialize() and TMR0_Initialize() functions should have been called
+    before calling this function.
+
+  @Param
+    rxData  - Location receiving the byte
+    timeout - Time to wait for the byte, in ms
+
+  @Returns
+    true  - A byte was read
+    false - No byte was received within the timeout
+*/
+bool EUSART1_ReadTimeout(uint8_t *rxData, uint16_t timeout);
+
+/**
+  @Summary
+    Selects the EUSART1 line mode.
+
+  @Description
+    In line mode the receive interrupt assembles the received characters into
+    lines instead of queuing them in the receive ring. A line ends with a CR
+    or LF character, when it reaches EUSART1_LINE_SIZE - 1 characters, or
+    when EUSART1_GetLine() finds the receive line idle, see
+    EUSART1_SetIdleCharacters(). Empty lines are ignored. Two line buffers are used: the interrupt fills
+    one while the last completed line is held in the other until
+    EUSART1_ReleaseLine() is called. A line completed while the previous one
+    is still held is dropped and counted as dropped bytes.
+    EUSART1_Read() and EUSART1_ReadBlock() return no data in line mode.
+    Switching mode discards the pending received data.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    enable - true to assemble lines, false to queue bytes in the receive ring
+
+  @Returns
+    None
+*/
+void EUSART1_SetLineMode(bool enable);
+
+/**
+  @Summary
+    Returns the last line completed in line mode.
+
+  @Description
+    This routine returns the completed line as a NUL terminated string, without
+    the CR or LF character. The line stays valid until EUSART1_ReleaseLine()
+    is called.
+
+  @Preconditions
+    EUSART1_SetLineMode(true) should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    The completed line, NULL if no line is ready
+
+  @Example
+    <code>
+    const char *line = EUSART1_GetLine();
+
+    if(NULL != line)
+    {
+        // process the line
+        EUSART1_ReleaseLine();
+    }
+    </code>
+*/
+const char *EUSART1_GetLine(void);
+
+/**
+  @Summary
+    Releases the line returned by EUSART1_GetLine().
+
+  @Description
+    This routine hands the line buffer back to the receive interrupt, so the
+    next completed line can be returned.
+
+  @Preconditions
+    EUSART1_GetLine() should have returned a line.
+
+  @Param
+    None
+
+  @Returns
+    None
+*/
+void EUSART1_ReleaseLine(void);
+
 /**
   @Summary
     Maintains the driver's transmitter state machine and implements its ISR.
@@ -485,6 +840,53 @@ void EUSART1_SetErrorHandler(void (* interruptHandler)(void));
 */
 void EUSART1_SetTxInterruptHandler(void (* interruptHandler)(void));
 
+/**
+  @Summary
+    Sets the function called when the transmit ring has drained
+
+  @Description
+    Calling this function will set a new custom function that will be 
+    called from the transmit interrupt once the last queued byte has been
+    handed to the transmitter.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    for the ISR to execute correctly.
+
+  @Param
+    A pointer to the new function
+
+  @Returns
+    None
+*/
+void EUSART1_SetTxDrainedHandler(void (* interruptHandler)(void));
+
+/**
+  @Summary
+    Changes the EUSART1 baud rate
+
+  @Description
+    This routine waits until every queued byte has been shifted out, then
+    reloads the baud rate generator. The wait is limited to
+    EUSART1_DRAIN_TIMEOUT ms, a stalled transmitter (e.g. CTS held high)
+    leaves the baud rate unchanged.
+
+  @Preconditions
+    EUSART1_Initialize() function should have been called
+    before calling this function. Interrupts must be enabled.
+
+  @Param
+    divisor - Baud rate generator value, see EUSART1_BAUD_DIVISOR()
+
+  @Returns
+    true - the new baud rate is in use
+    false - the transmitter did not drain, the baud rate is unchanged
+
+  @Example
+    EUSART1_SetBaudDivisor(EUSART1_BAUD_DIVISOR(115200UL));
+*/
+bool EUSART1_SetBaudDivisor(uint16_t divisor);
+
 /**
   @Summary
     Sets the receive handler function to be called by the interrupt service
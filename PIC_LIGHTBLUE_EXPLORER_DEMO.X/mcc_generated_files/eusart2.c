@@ -47,14 +47,43 @@
 /**
   Section: Included Files
 */
+#include <string.h>
 #include "eusart2.h"
+#include "tmr0.h"
+#include "pin_manager.h"
 
 /**
   Section: Macro Declarations
 */
 
-#define EUSART2_TX_BUFFER_SIZE 8
-#define EUSART2_RX_BUFFER_SIZE 8
+#ifndef EUSART2_TX_BUFFER_SIZE
+#define EUSART2_TX_BUFFER_SIZE 64
+#endif
+#ifndef EUSART2_IDLE_CHARACTERS
+#define EUSART2_IDLE_CHARACTERS 4
+#endif
+#ifndef EUSART2_RX_BUFFER_SIZE
+#define EUSART2_RX_BUFFER_SIZE 32
+#endif
+
+#if (EUSART2_TX_BUFFER_SIZE < 2) || (EUSART2_TX_BUFFER_SIZE > 128) || (EUSART2_TX_BUFFER_SIZE & (EUSART2_TX_BUFFER_SIZE - 1))
+#error "EUSART2_TX_BUFFER_SIZE must be a power of two between 2 and 128"
+#endif
+#if (EUSART2_RX_BUFFER_SIZE < 2) || (EUSART2_RX_BUFFER_SIZE > 128) || (EUSART2_RX_BUFFER_SIZE & (EUSART2_RX_BUFFER_SIZE - 1))
+#error "EUSART2_RX_BUFFER_SIZE must be a power of two between 2 and 128"
+#endif
+
+#define EUSART2_TX_BUFFER_MASK (EUSART2_TX_BUFFER_SIZE - 1)
+#define EUSART2_RX_BUFFER_MASK (EUSART2_RX_BUFFER_SIZE - 1)
+
+#if BLE_UART_FLOW_CONTROL
+#if (BLE_UART_RTS_MARGIN >= EUSART2_RX_BUFFER_SIZE)
+#error "BLE_UART_RTS_MARGIN must be smaller than EUSART2_RX_BUFFER_SIZE"
+#endif
+// RTS is deasserted at this fill level and asserted again once the ring is half empty
+#define EUSART2_RTS_STOP_LEVEL (EUSART2_RX_BUFFER_SIZE - BLE_UART_RTS_MARGIN)
+#define EUSART2_RTS_START_LEVEL (EUSART2_RX_BUFFER_SIZE / 2)
+#endif
 
 /**
   Section: Global Variables
@@ -71,6 +100,18 @@ volatile eusart2_status_t eusart2RxStatusBuffer[EUSART2_RX_BUFFER_SIZE];
 volatile uint8_t eusart2RxCount;
 volatile eusart2_status_t eusart2RxLastError;
 
+volatile eusart_counters_t eusart2Counters;
+
+// idle gap: TMR0 time of the last received byte, cleared once the line went quiet
+volatile uint16_t eusart2RxStamp;
+volatile bool eusart2RxActive = false;
+uint8_t eusart2IdleCharacters = EUSART2_IDLE_CHARACTERS;
+uint16_t eusart2IdleTicks;
+
+#if BLE_UART_FLOW_CONTROL
+volatile bool eusart2FlowControl = false;
+#endif
+
 /**
   Section: EUSART2 APIs
 */
@@ -80,10 +121,17 @@ void (*EUSART2_RxDefaultInterruptHandler)(void);
 void (*EUSART2_FramingErrorHandler)(void);
 void (*EUSART2_OverrunErrorHandler)(void);
 void (*EUSART2_ErrorHandler)(void);
+void (*EUSART2_TxDrainedHandler)(void);
 
 void EUSART2_DefaultFramingErrorHandler(void);
 void EUSART2_DefaultOverrunErrorHandler(void);
 void EUSART2_DefaultErrorHandler(void);
+void EUSART2_DefaultTxDrainedHandler(void);
+
+static void EUSART2_UpdateIdleTicks(void);
+#if BLE_UART_FLOW_CONTROL
+void EUSART2_CtsAssertedHandler(void);
+#endif
 
 void EUSART2_Initialize(void)
 {
@@ -109,10 +157,12 @@ void EUSART2_Initialize(void)
     // SP2BRGH 3; 
     SP2BRGH = 0x03;
 
+    EUSART2_UpdateIdleTicks();
 
     EUSART2_SetFramingErrorHandler(EUSART2_DefaultFramingErrorHandler);
     EUSART2_SetOverrunErrorHandler(EUSART2_DefaultOverrunErrorHandler);
     EUSART2_SetErrorHandler(EUSART2_DefaultErrorHandler);
+    EUSART2_SetTxDrainedHandler(EUSART2_DefaultTxDrainedHandler);
 
     eusart2RxLastError.status = 0;
 
@@ -125,6 +175,16 @@ void EUSART2_Initialize(void)
     eusart2RxTail = 0;
     eusart2RxCount = 0;
 
+    memset((void *)&eusart2Counters, 0, sizeof(eusart2Counters));
+
+#if BLE_UART_FLOW_CONTROL
+    // ready to receive; CTS is ignored until EUSART2_SetFlowControl(true)
+    eusart2FlowControl = false;
+    BT_RTS_SetLow();
+    IOCCF2_SetInterruptHandler(EUSART2_CtsAssertedHandler);
+    IOCCNbits.IOCCN2 = 1;
+#endif
+
     // enable receive interrupt
     PIE3bits.RC2IE = 1;
 }
@@ -158,13 +218,16 @@ uint8_t EUSART2_Read(void)
 
     eusart2RxLastError = eusart2RxStatusBuffer[eusart2RxTail];
 
-    readValue = eusart2RxBuffer[eusart2RxTail++];
-    if(sizeof(eusart2RxBuffer) <= eusart2RxTail)
-    {
-        eusart2RxTail = 0;
-    }
+    readValue = eusart2RxBuffer[eusart2RxTail];
+    eusart2RxTail = (eusart2RxTail + 1) & EUSART2_RX_BUFFER_MASK;
     PIE3bits.RC2IE = 0;
     eusart2RxCount--;
+#if BLE_UART_FLOW_CONTROL
+    if(EUSART2_RTS_START_LEVEL >= eusart2RxCount)
+    {
+        BT_RTS_SetLow();
+    }
+#endif
     PIE3bits.RC2IE = 1;
 
     return readValue;
@@ -172,63 +235,163 @@ uint8_t EUSART2_Read(void)
 
 void EUSART2_Write(uint8_t txData)
 {
+    if(0 == eusart2TxBufferRemaining)
+    {
+        eusart2Counters.txStalls++;
+    }
     while(0 == eusart2TxBufferRemaining)
     {
     }
 
+#if BLE_UART_FLOW_CONTROL
+    // with flow control the ring may hold bytes paused by CTS, keep the order
+    if((0 == PIE3bits.TX2IE) && (false == eusart2FlowControl))
+#else
     if(0 == PIE3bits.TX2IE)
+#endif
     {
         TX2REG = txData;
+        eusart2Counters.txBytes++;
     }
     else
     {
         PIE3bits.TX2IE = 0;
-        eusart2TxBuffer[eusart2TxHead++] = txData;
-        if(sizeof(eusart2TxBuffer) <= eusart2TxHead)
+        eusart2TxBuffer[eusart2TxHead] = txData;
+        eusart2TxHead = (eusart2TxHead + 1) & EUSART2_TX_BUFFER_MASK;
+        eusart2TxBufferRemaining--;
+        if((EUSART2_TX_BUFFER_SIZE - eusart2TxBufferRemaining) > eusart2Counters.txHighWater)
         {
-            eusart2TxHead = 0;
+            eusart2Counters.txHighWater = EUSART2_TX_BUFFER_SIZE - eusart2TxBufferRemaining;
         }
-        eusart2TxBufferRemaining--;
     }
     PIE3bits.TX2IE = 1;
 }
 
 
+uint8_t EUSART2_ReadBlock(uint8_t *rxData, uint8_t maxLength)
+{
+    uint8_t count;
+    uint8_t index;
+
+    PIE3bits.RC2IE = 0;
+    count = (eusart2RxCount < maxLength) ? eusart2RxCount : maxLength;
+    for(index = 0; index < count; index++)
+    {
+        eusart2RxLastError = eusart2RxStatusBuffer[eusart2RxTail];
+        rxData[index] = eusart2RxBuffer[eusart2RxTail];
+        eusart2RxTail = (eusart2RxTail + 1) & EUSART2_RX_BUFFER_MASK;
+    }
+    eusart2RxCount -= count;
+#if BLE_UART_FLOW_CONTROL
+    if(EUSART2_RTS_START_LEVEL >= eusart2RxCount)
+    {
+        BT_RTS_SetLow();
+    }
+#endif
+    PIE3bits.RC2IE = 1;
+
+    return count;
+}
+
+uint8_t EUSART2_GetTxSpace(void)
+{
+    return eusart2TxBufferRemaining;
+}
+
+uint8_t EUSART2_TryWriteBlock(const uint8_t *txData, uint8_t length)
+{
+    uint8_t count;
+    uint8_t index;
+
+    PIE3bits.TX2IE = 0;
+    count = (eusart2TxBufferRemaining < length) ? eusart2TxBufferRemaining : length;
+    for(index = 0; index < count; index++)
+    {
+        eusart2TxBuffer[eusart2TxHead] = txData[index];
+        eusart2TxHead = (eusart2TxHead + 1) & EUSART2_TX_BUFFER_MASK;
+    }
+    eusart2TxBufferRemaining -= count;
+    if((EUSART2_TX_BUFFER_SIZE - eusart2TxBufferRemaining) > eusart2Counters.txHighWater)
+    {
+        eusart2Counters.txHighWater = EUSART2_TX_BUFFER_SIZE - eusart2TxBufferRemaining;
+    }
+    PIE3bits.TX2IE = (EUSART2_TX_BUFFER_SIZE > eusart2TxBufferRemaining);
+
+    return count;
+}
+
+void EUSART2_WriteBlock(const uint8_t *txData, uint8_t length)
+{
+    uint8_t count;
+
+    while(length)
+    {
+        if(0 == eusart2TxBufferRemaining)
+        {
+            eusart2Counters.txStalls++;
+        }
+        while(0 == eusart2TxBufferRemaining)
+        {
+        }
+
+        count = EUSART2_TryWriteBlock(txData, length);
+        txData += count;
+        length -= count;
+    }
+}
+
+
 void EUSART2_Transmit_ISR(void)
 {
 
     // add your EUSART2 interrupt custom code
+#if BLE_UART_FLOW_CONTROL
+    if(eusart2FlowControl && BT_CTS_GetValue())
+    {
+        // RN487X cannot take more data; resumed from the CTS interrupt-on-change
+        PIE3bits.TX2IE = 0;
+        return;
+    }
+#endif
     if(sizeof(eusart2TxBuffer) > eusart2TxBufferRemaining)
     {
-        TX2REG = eusart2TxBuffer[eusart2TxTail++];
-        if(sizeof(eusart2TxBuffer) <= eusart2TxTail)
-        {
-            eusart2TxTail = 0;
-        }
+        TX2REG = eusart2TxBuffer[eusart2TxTail];
+        eusart2Counters.txBytes++;
+        eusart2TxTail = (eusart2TxTail + 1) & EUSART2_TX_BUFFER_MASK;
         eusart2TxBufferRemaining++;
     }
     else
     {
         PIE3bits.TX2IE = 0;
+        EUSART2_TxDrainedHandler();
     }
 }
 
 void EUSART2_Receive_ISR(void)
 {
-    
-    eusart2RxStatusBuffer[eusart2RxHead].status = 0;
+    eusart2_status_t rxStatus;
+
+    rxStatus.status = 0;
 
     if(RC2STAbits.FERR){
-        eusart2RxStatusBuffer[eusart2RxHead].ferr = 1;
+        rxStatus.ferr = 1;
+        eusart2Counters.framingErrors++;
         EUSART2_FramingErrorHandler();
     }
 
     if(RC2STAbits.OERR){
-        eusart2RxStatusBuffer[eusart2RxHead].oerr = 1;
+        rxStatus.oerr = 1;
+        eusart2Counters.overrunErrors++;
         EUSART2_OverrunErrorHandler();
     }
-    
-    if(eusart2RxStatusBuffer[eusart2RxHead].status){
+
+    // a full ring drops the byte - keep the status of the oldest unread
+    // byte and leave the error in the counters only
+    if(EUSART2_RX_BUFFER_SIZE > eusart2RxCount){
+        eusart2RxStatusBuffer[eusart2RxHead] = rxStatus;
+    }
+
+    if(rxStatus.status){
         EUSART2_ErrorHandler();
     } else {
         EUSART2_RxDataHandler();
@@ -239,12 +402,74 @@ void EUSART2_Receive_ISR(void)
 
 void EUSART2_RxDataHandler(void){
     // use this default receive interrupt handler code
-    eusart2RxBuffer[eusart2RxHead++] = RC2REG;
-    if(sizeof(eusart2RxBuffer) <= eusart2RxHead)
+    uint8_t rxData = RC2REG;
+
+    eusart2Counters.rxBytes++;
+    eusart2RxStamp = TMR0_ReadTimer();
+    eusart2RxActive = true;
+    if(EUSART2_RX_BUFFER_SIZE <= eusart2RxCount)
     {
-        eusart2RxHead = 0;
+        // ring full - drop the byte rather than overwrite unread data
+        eusart2Counters.rxDropped++;
+        return;
     }
+    eusart2RxBuffer[eusart2RxHead] = rxData;
+    eusart2RxHead = (eusart2RxHead + 1) & EUSART2_RX_BUFFER_MASK;
     eusart2RxCount++;
+    if(eusart2RxCount > eusart2Counters.rxHighWater)
+    {
+        eusart2Counters.rxHighWater = eusart2RxCount;
+    }
+#if BLE_UART_FLOW_CONTROL
+    if(EUSART2_RTS_STOP_LEVEL <= eusart2RxCount)
+    {
+        BT_RTS_SetHigh();
+    }
+#endif
+}
+
+uint8_t EUSART2_GetTxHighWater(void)
+{
+    return eusart2Counters.txHighWater;
+}
+
+uint8_t EUSART2_GetRxHighWater(void)
+{
+    return eusart2Counters.rxHighWater;
+}
+
+void EUSART2_ResetHighWater(void)
+{
+    PIE3bits.TX2IE = 0;
+    PIE3bits.RC2IE = 0;
+    eusart2Counters.txHighWater = EUSART2_TX_BUFFER_SIZE - eusart2TxBufferRemaining;
+    eusart2Counters.rxHighWater = eusart2RxCount;
+    PIE3bits.RC2IE = 1;
+    PIE3bits.TX2IE = (EUSART2_TX_BUFFER_SIZE > eusart2TxBufferRemaining);
+}
+
+void EUSART2_GetCounters(eusart_counters_t *counters)
+{
+    bool txState = PIE3bits.TX2IE;
+
+    PIE3bits.TX2IE = 0;
+    PIE3bits.RC2IE = 0;
+    *counters = eusart2Counters;
+    PIE3bits.RC2IE = 1;
+    PIE3bits.TX2IE = txState;
+}
+
+void EUSART2_ResetCounters(void)
+{
+    bool txState = PIE3bits.TX2IE;
+
+    PIE3bits.TX2IE = 0;
+    PIE3bits.RC2IE = 0;
+    memset((void *)&eusart2Counters, 0, sizeof(eusart2Counters));
+    eusart2Counters.txHighWater = EUSART2_TX_BUFFER_SIZE - eusart2TxBufferRemaining;
+    eusart2Counters.rxHighWater = eusart2RxCount;
+    PIE3bits.RC2IE = 1;
+    PIE3bits.TX2IE = txState;
 }
 
 void EUSART2_DefaultFramingErrorHandler(void){}
@@ -261,6 +486,25 @@ void EUSART2_DefaultErrorHandler(void){
     EUSART2_RxDataHandler();
 }
 
+void EUSART2_DefaultTxDrainedHandler(void){}
+
+#if BLE_UART_FLOW_CONTROL
+void EUSART2_CtsAssertedHandler(void){
+    if(sizeof(eusart2TxBuffer) > eusart2TxBufferRemaining)
+    {
+        PIE3bits.TX2IE = 1;
+    }
+}
+
+void EUSART2_SetFlowControl(bool enable){
+    eusart2FlowControl = enable;
+    if(sizeof(eusart2TxBuffer) > eusart2TxBufferRemaining)
+    {
+        PIE3bits.TX2IE = 1;
+    }
+}
+#endif
+
 void EUSART2_SetFramingErrorHandler(void (* interruptHandler)(void)){
     EUSART2_FramingErrorHandler = interruptHandler;
 }
@@ -273,6 +517,83 @@ void EUSART2_SetErrorHandler(void (* interruptHandler)(void)){
     EUSART2_ErrorHandler = interruptHandler;
 }
 
+bool EUSART2_SetBaudDivisor(uint16_t divisor){
+    uint32_t limit = (uint32_t)EUSART2_DRAIN_TIMEOUT * TMR0_TICK_FREQUENCY / 1000;
+    uint32_t elapsed = 0;
+    uint16_t last = TMR0_ReadTimestamp();
+    uint16_t now;
+
+    while((EUSART2_TX_BUFFER_SIZE != eusart2TxBufferRemaining) || (0 == TX2STAbits.TRMT))
+    {
+        now = TMR0_ReadTimestamp();
+        elapsed += (uint16_t)(now - last);
+        last = now;
+        if(elapsed >= limit)
+        {
+            return false;
+        }
+    }
+
+    SP2BRGL = (uint8_t)divisor;
+    SP2BRGH = (uint8_t)(divisor >> 8);
+    EUSART2_UpdateIdleTicks();
+    return true;
+}
+
+void EUSART2_SetIdleCharacters(uint8_t characters){
+    eusart2IdleCharacters = characters;
+    EUSART2_UpdateIdleTicks();
+}
+
+bool EUSART2_IsRxIdle(void){
+    bool state = INTCONbits.GIE;
+    bool idle;
+
+    // TMR0 is also read by the receive interrupts, keep its high byte latch ours
+    INTCONbits.GIE = 0;
+    if(eusart2RxActive && ((uint16_t)(TMR0_ReadTimer() - eusart2RxStamp) >= eusart2IdleTicks))
+    {
+        eusart2RxActive = false;
+    }
+    idle = !eusart2RxActive;
+    INTCONbits.GIE = state;
+
+    return idle;
+}
+
+bool EUSART2_ReadTimeout(uint8_t *rxData, uint16_t timeout){
+    uint32_t limit = (uint32_t)timeout * TMR0_TICK_FREQUENCY / 1000;
+    uint32_t elapsed = 0;
+    uint16_t last = TMR0_ReadTimestamp();
+    uint16_t now;
+
+    while(0 == eusart2RxCount)
+    {
+        now = TMR0_ReadTimestamp();
+        elapsed += (uint16_t)(now - last);
+        last = now;
+        if(elapsed >= limit)
+        {
+            return false;
+        }
+    }
+
+    *rxData = EUSART2_Read();
+    return true;
+}
+
+static void EUSART2_UpdateIdleTicks(void){
+    uint16_t divisor = ((uint16_t)SP2BRGH << 8) | SP2BRGL;
+    // (10) bit times per character, SP2BRG + 1 FOSC/4 clocks per bit time
+    uint32_t ticks = ((uint32_t)eusart2IdleCharacters * 10 * ((uint32_t)divisor + 1) + (TMR0_PRESCALER - 1)) / TMR0_PRESCALER;
+
+    eusart2IdleTicks = (ticks > UINT16_MAX) ? UINT16_MAX : (uint16_t)ticks;
+}
+
+void EUSART2_SetTxDrainedHandler(void (* interruptHandler)(void)){
+    EUSART2_TxDrainedHandler = interruptHandler;
+}
+
 void EUSART2_SetTxInterruptHandler(void (* interruptHandler)(void)){
     EUSART2_TxDefaultInterruptHandler = interruptHandler;
 }
@@ -54,6 +54,8 @@
 #include <xc.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "eusart_counters.h"
+#include "config/BLE_Explorer_config.h"
 
 #ifdef __cplusplus  // Provide C++ Compatibility
 
@@ -68,6 +70,24 @@
 
 #define EUSART2_DataReady  (EUSART2_is_rx_ready())
 
+/**
+  @Summary
+    Baud rate generator value for a baud rate
+
+  @Description
+    Rounded SP2BRG value for the 16-bit, high speed generator (BRG16 = 1,
+    BRGH = 1) used by EUSART2_Initialize(). The achieved rate is
+    _XTAL_FREQ / (4 * (divisor + 1)).
+*/
+#define EUSART2_BAUD_DIVISOR(baud) ((uint16_t)((((_XTAL_FREQ) + (2UL * (baud))) / (4UL * (baud))) - 1))
+
+/**
+  @Description
+    Longest time, in milliseconds, EUSART2_SetBaudDivisor() waits for the
+    queued bytes to be shifted out. Covers a full transmit buffer at 9600 baud.
+*/
+#define EUSART2_DRAIN_TIMEOUT (100)
+
 /**
   Section: Data Type Definitions
 */
@@ -347,6 +367,263 @@ uint8_t EUSART2_Read(void);
 */
 void EUSART2_Write(uint8_t txData);
 
+/**
+  @Summary
+    Reads a block of received data from the EUSART2.
+
+  @Description
+    This routine copies up to maxLength bytes that are already waiting in the
+    EUSART2 receive ring into rxData. The receive interrupt is masked once for
+    the whole block. It does not wait for data to arrive.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    rxData    - Buffer receiving the data
+    maxLength - Size of rxData in bytes
+
+  @Returns
+    Number of bytes copied into rxData.
+*/
+uint8_t EUSART2_ReadBlock(uint8_t *rxData, uint8_t maxLength);
+
+/**
+  @Summary
+    Writes a block of data to the EUSART2.
+
+  @Description
+    This routine copies length bytes into the EUSART2 transmit ring, masking
+    the transmit interrupt once per copied chunk rather than once per byte.
+    It waits for free space when the block is larger than the ring.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    txData - Data to write to the EUSART2
+    length - Number of bytes to write
+
+  @Returns
+    None
+*/
+void EUSART2_WriteBlock(const uint8_t *txData, uint8_t length);
+
+/**
+  @Summary
+    Writes as much of a block of data to the EUSART2 as fits without waiting.
+
+  @Description
+    This routine copies up to length bytes into the free space of the EUSART2
+    transmit ring and returns immediately. The bytes that were not accepted
+    are left to the caller.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    txData - Data to write to the EUSART2
+    length - Number of bytes to write
+
+  @Returns
+    Number of bytes accepted into the transmit ring.
+*/
+uint8_t EUSART2_TryWriteBlock(const uint8_t *txData, uint8_t length);
+
+/**
+  @Summary
+    Returns the free space of the EUSART2 transmit ring.
+
+  @Description
+    This routine returns how many bytes EUSART2_TryWriteBlock() can currently
+    accept without dropping any.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    Number of free bytes in the transmit ring.
+*/
+uint8_t EUSART2_GetTxSpace(void);
+
+/**
+  @Summary
+    Returns the peak transmit ring occupancy.
+
+  @Description
+    This routine returns the largest number of bytes that have been queued
+    in the EUSART2 transmit ring since initialization or the last call to
+    EUSART2_ResetHighWater(). A value equal to EUSART2_TX_BUFFER_SIZE means
+    EUSART2_Write() has had to wait for free space.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    Peak number of bytes held in the transmit ring.
+*/
+uint8_t EUSART2_GetTxHighWater(void);
+
+/**
+  @Summary
+    Returns the peak receive ring occupancy.
+
+  @Description
+    This routine returns the largest number of unread bytes that have been
+    held in the EUSART2 receive ring since initialization or the last call to
+    EUSART2_ResetHighWater(). A value equal to EUSART2_RX_BUFFER_SIZE means
+    received bytes may have been dropped.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    Peak number of bytes held in the receive ring.
+*/
+uint8_t EUSART2_GetRxHighWater(void);
+
+/**
+  @Summary
+    Restarts the ring high-water-mark measurement.
+
+  @Description
+    This routine resets both high-water marks to the current ring occupancy.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    None
+*/
+void EUSART2_ResetHighWater(void);
+
+/**
+  @Summary
+    Reads the EUSART2 traffic and error counters.
+
+  @Description
+    This routine copies the byte, error, drop and stall counters and the
+    ring high-water marks accumulated since initialization or the last call
+    to EUSART2_ResetCounters(). The 16-bit counters wrap around.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    counters - Structure receiving the counters
+
+  @Returns
+    None
+*/
+void EUSART2_GetCounters(eusart_counters_t *counters);
+
+/**
+  @Summary
+    Clears the EUSART2 traffic and error counters.
+
+  @Description
+    This routine clears every counter and restarts the high-water marks from
+    the current ring occupancy.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    None
+*/
+void EUSART2_ResetCounters(void);
+
+/**
+  @Summary
+    Sets the EUSART2 receive idle gap.
+
+  @Description
+    The receive line is idle once no character was received for the given
+    number of character times, at the current baud rate. The gap is measured
+    with TMR0 and is limited to one TMR0 period, about 1 s. The default is
+    EUSART2_IDLE_CHARACTERS.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    before calling this function.
+
+  @Param
+    characters - Idle gap in character times
+
+  @Returns
+    None
+*/
+void EUSART2_SetIdleCharacters(uint8_t characters);
+
+/**
+  @Summary
+    Checks for the end of a received burst.
+
+  @Description
+    This routine returns true once the idle gap has elapsed since the last
+    received character, marking the end of a burst of data. It should be
+    polled at least once per TMR0 period while data is received, as a longer
+    gap may appear shorter once the 16-bit timer wrapped.
+
+  @Preconditions
+    EUSART2_Initialize() and TMR0_Initialize() functions should have been called
+    before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    true  - No character received during the idle gap
+    false - A burst is in progress
+*/
+bool EUSART2_IsRxIdle(void);
+
+/**
+  @Summary
+    Read a byte of data from the EUSART2, waiting at most the given time.
+
+  @Description
+    This routine returns the next received byte, like EUSART2_Read(), but
+    gives up if no byte arrives within the timeout.
+
+  @Preconditions
+    EUSART2_Initialize() and TMR0_Initialize() functions should have been called
+    before calling this function.
+
+  @Param
+    rxData  - Location receiving the byte
+    timeout - Time to wait for the byte, in ms
+
+  @Returns
+    true  - A byte was read
+    false - No byte was received within the timeout
+*/
+bool EUSART2_ReadTimeout(uint8_t *rxData, uint16_t timeout);
+
 /**
   @Summary
     Maintains the driver's transmitter state machine and implements its ISR.
@@ -484,6 +761,76 @@ void EUSART2_SetErrorHandler(void (* interruptHandler)(void));
 */
 void EUSART2_SetTxInterruptHandler(void (* interruptHandler)(void));
 
+/**
+  @Summary
+    Sets the function called when the transmit ring has drained
+
+  @Description
+    Calling this function will set a new custom function that will be 
+    called from the transmit interrupt once the last queued byte has been
+    handed to the transmitter.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    for the ISR to execute correctly.
+
+  @Param
+    A pointer to the new function
+
+  @Returns
+    None
+*/
+void EUSART2_SetTxDrainedHandler(void (* interruptHandler)(void));
+
+/**
+  @Summary
+    Changes the EUSART2 baud rate
+
+  @Description
+    This routine waits until every queued byte has been shifted out, then
+    reloads the baud rate generator. The wait is limited to
+    EUSART2_DRAIN_TIMEOUT ms, a stalled transmitter (e.g. CTS held high)
+    leaves the baud rate unchanged.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called
+    before calling this function. Interrupts must be enabled.
+
+  @Param
+    divisor - Baud rate generator value, see EUSART2_BAUD_DIVISOR()
+
+  @Returns
+    true - the new baud rate is in use
+    false - the transmitter did not drain, the baud rate is unchanged
+
+  @Example
+    EUSART2_SetBaudDivisor(EUSART2_BAUD_DIVISOR(115200UL));
+*/
+bool EUSART2_SetBaudDivisor(uint16_t divisor);
+
+#if BLE_UART_FLOW_CONTROL
+/**
+  @Summary
+    Enables or disables CTS gating of the EUSART2 transmitter
+
+  @Description
+    With flow control enabled the transmit interrupt stops sending while the
+    RN487X deasserts CTS and resumes on the CTS interrupt-on-change. RTS is
+    always driven from the receive ring fill level.
+
+  @Preconditions
+    EUSART2_Initialize() function should have been called and the RN487X
+    configured for flow control before enabling it.
+
+  @Param
+    enable - true to honor CTS, false to ignore it
+
+  @Returns
+    None
+*/
+void EUSART2_SetFlowControl(bool enable);
+#endif
+
 /**
   @Summary
     Sets the receive handler function to be called by the interrupt service
@@ -0,0 +1,80 @@
+/**
+  EUSART Statistics Counters Header File
+
+  @Company
+    Microchip Technology Inc.
+
+  @File Name
+    eusart_counters.h
+
+  @Summary
+    This is the header file for the statistics counters shared by the EUSART drivers
+
+  @Description
+    This header file defines the counter set reported by EUSART1_GetCounters()
+    and EUSART2_GetCounters(), and through the uart[] GetCounters entry.
+*/
+
+/*
+    (c) 2018 Microchip Technology Inc. and its subsidiaries. 
+    
+    Subject to your compliance with these terms, you may use Microchip software and any 
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party 
+    license terms applicable to your use of third party software (including open source software) that 
+    may accompany Microchip software.
+    
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER 
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY 
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS 
+    FOR A PARTICULAR PURPOSE.
+    
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND 
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP 
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO 
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL 
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT 
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS 
+    SOFTWARE.
+*/
+
+#ifndef EUSART_COUNTERS_H
+#define EUSART_COUNTERS_H
+
+/**
+  Section: Included Files
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+    extern "C" {
+
+#endif
+
+/**
+  Section: Data Type Definitions
+*/
+
+typedef struct {
+    uint16_t txBytes;           // bytes handed to the transmitter
+    uint16_t rxBytes;           // bytes received, dropped ones included
+    uint16_t overrunErrors;     // receiver overruns (OERR)
+    uint16_t framingErrors;     // framing errors (FERR)
+    uint16_t rxDropped;         // bytes dropped because the receive ring was full
+    uint16_t txStalls;          // writes that had to wait for transmit ring space
+    uint8_t txHighWater;        // peak transmit ring occupancy
+    uint8_t rxHighWater;        // peak receive ring occupancy
+}eusart_counters_t;
+
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+    }
+
+#endif
+
+#endif  // EUSART_COUNTERS_H
+/**
+ End of File
+*/
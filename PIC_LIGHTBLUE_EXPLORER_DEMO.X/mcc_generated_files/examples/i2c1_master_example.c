@@ -64,7 +64,7 @@ uint8_t I2C1_Read1ByteRegister(i2c1_address_t address, uint8_t reg)
 {
     uint8_t returnValue = 0x00;
     
-    while(!I2C1_Open(address)); // sit here until we get the bus..
+    while(I2C1_NOERR != I2C1_Open(address)); // sit here until we get the bus..
     I2C1_SetDataCompleteCallback(rd1RegCompleteHandler,&returnValue);
     I2C1_SetBuffer(&reg,1);
     I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
@@ -78,7 +78,7 @@ uint16_t I2C1_Read2ByteRegister(i2c1_address_t address, uint8_t reg)
 {
     uint16_t returnValue =0x00; // returnValue is little endian
 
-    while(!I2C1_Open(address)); // sit here until we get the bus..
+    while(I2C1_NOERR != I2C1_Open(address)); // sit here until we get the bus..
     I2C1_SetDataCompleteCallback(rd2RegCompleteHandler,&returnValue);
     I2C1_SetBuffer(&reg,1);
     I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
@@ -90,7 +90,7 @@ uint16_t I2C1_Read2ByteRegister(i2c1_address_t address, uint8_t reg)
 
 void I2C1_Write1ByteRegister(i2c1_address_t address, uint8_t reg, uint8_t data)
 {
-    while(!I2C1_Open(address)); // sit here until we get the bus..
+    while(I2C1_NOERR != I2C1_Open(address)); // sit here until we get the bus..
     I2C1_SetDataCompleteCallback(wr1RegCompleteHandler,&data);
     I2C1_SetBuffer(&reg,1);
     I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
@@ -100,7 +100,7 @@ void I2C1_Write1ByteRegister(i2c1_address_t address, uint8_t reg, uint8_t data)
 
 void I2C1_Write2ByteRegister(i2c1_address_t address, uint8_t reg, uint16_t data)
 {
-    while(!I2C1_Open(address)); // sit here until we get the bus..
+    while(I2C1_NOERR != I2C1_Open(address)); // sit here until we get the bus..
     I2C1_SetDataCompleteCallback(wr2RegCompleteHandler,&data);
     I2C1_SetBuffer(&reg,1);
     I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
@@ -110,7 +110,7 @@ void I2C1_Write2ByteRegister(i2c1_address_t address, uint8_t reg, uint16_t data)
 
 void I2C1_WriteNBytes(i2c1_address_t address, uint8_t* data, size_t len)
 {
-    while(!I2C1_Open(address)); // sit here until we get the bus..
+    while(I2C1_NOERR != I2C1_Open(address)); // sit here until we get the bus..
     I2C1_SetBuffer(data,len);
     I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
     I2C1_MasterWrite();
@@ -119,7 +119,7 @@ void I2C1_WriteNBytes(i2c1_address_t address, uint8_t* data, size_t len)
 
 void I2C1_ReadNBytes(i2c1_address_t address, uint8_t *data, size_t len)
 {
-    while(!I2C1_Open(address)); // sit here until we get the bus..
+    while(I2C1_NOERR != I2C1_Open(address)); // sit here until we get the bus..
     I2C1_SetBuffer(data,len);
     I2C1_MasterRead();
     while(I2C1_BUSY == I2C1_Close()); // sit here until finished.
@@ -131,7 +131,7 @@ void I2C1_ReadDataBlock(i2c1_address_t address, uint8_t reg, uint8_t *data, size
     bufferBlock.data = data;
     bufferBlock.len = len;
 
-    while(!I2C1_Open(address)); // sit here until we get the bus..
+    while(I2C1_NOERR != I2C1_Open(address)); // sit here until we get the bus..
     I2C1_SetDataCompleteCallback(rdBlkRegCompleteHandler,&bufferBlock);
     I2C1_SetBuffer(&reg,1);
     I2C1_SetAddressNackCallback(NULL,NULL); //NACK polling?
@@ -101,28 +101,9 @@ static bool RN487X_Example_TransparentUart(void)
    bool isConnected;
    isConnected = RN487X_IsConnected();
 
-   if (true == isConnected)
-   {
-       while (RN487X_DataReady())
-       {
-           uart[UART_CDC].Write(RN487X_Read());
-       }
-       while (uart[UART_CDC].DataReady())
-       {
-           RN487X.Write(uart[UART_CDC].Read());
-       }
-   }
-   else
-    {
-        while(RN487X_DataReady())
-        {
-            uart[UART_CDC].Write(RN487X_Read());
-        }
-        while (uart[UART_CDC].DataReady())
-        {
-            RN487X.Write(uart[UART_CDC].Read());
-        }
-    }
+   // Connected or not, the UART interrupts forward the data both ways
+   RN487X_SetBridgeMode(true);
+   RN487X_BridgeTasks();
 
     return isConnected;
 }
@@ -45,8 +45,21 @@
 */
 
 #include "i2c1_master.h"
+#include "device_config.h"
+#include "tmr0.h"
 #include <xc.h>
 
+// SSP1ADD value for a bus clock, SCL = FOSC / (4 * (SSP1ADD + 1))
+#define I2C1_BAUD_DIVISOR(clock)    ((uint8_t)((_XTAL_FREQ / (4UL * (clock))) - 1))
+
+// I2C1 transaction queue depth, must be a power of two
+#define I2C1_QUEUE_SIZE         (4)
+#define I2C1_QUEUE_MASK         (I2C1_QUEUE_SIZE - 1)
+
+// Longest time a queued transaction may hold the bus, in ms, see I2C1_Tasks()
+#define I2C1_TRANSACTION_TIMEOUT    (20)
+#define I2C1_TIMEOUT_TICKS          ((uint16_t)((uint32_t)I2C1_TRANSACTION_TIMEOUT * TMR0_TICK_FREQUENCY / 1000))
+
 // I2C1 STATES
 typedef enum {
     I2C1_IDLE = 0,
@@ -94,12 +107,19 @@ typedef struct
     unsigned busy:1;
     unsigned inUse:1;
     unsigned bufferFree:1;
+    unsigned interruptDriven:1;
 
 } i2c1_status_t;
 
 static void I2C1_SetCallback(i2c1_callbackIndex_t idx, i2c1_callback_t cb, void *ptr);
 static void I2C1_Poller(void);
 static inline void I2C1_MasterFsm(void);
+static i2c1_operations_t I2C1_TransactionRegisterSent(void *ptr);
+static i2c1_operations_t I2C1_TransactionDataSent(void *ptr);
+static void I2C1_StartNextTransaction(void);
+static void I2C1_TransactionFinished(i2c1_error_t error);
+static bool I2C1_IsQueued(const i2c1_transaction_t *transaction);
+static void I2C1_ApplyClock(i2c1_clock_t clock);
 
 /* I2C1 interfaces */
 static inline bool I2C1_MasterOpen(void);
@@ -122,6 +142,7 @@ static inline bool I2C1_MasterIsIrqEnabled(void);
 static inline void I2C1_MasterDisableIrq(void);
 static inline void I2C1_MasterClearIrq(void);
 static inline void I2C1_MasterSetIrq(void);
+static inline void I2C1_MasterKick(void);
 static inline void I2C1_MasterWaitForEvent(void);
 
 static i2c1_fsm_states_t I2C1_DO_IDLE(void);
@@ -163,25 +184,55 @@ const i2c1FsmHandler i2c1_fsmStateTable[] = {
 };
 
 i2c1_status_t I2C1_Status = {0};
+static uint16_t i2c1TransactionCount = 0;   // START conditions issued, see I2C1_GetTransactionCount()
+static uint16_t i2c1BusTime = 0;            // TMR0 counts the bus was held, see I2C1_GetBusTime()
+static uint16_t i2c1BusStart;               // TMR0 count at the last START condition
+static i2c1_clock_t i2c1Clock = I2C1_CLOCK_100KHZ;
+
+// Indexed by i2c1_clock_t
+static const uint8_t i2c1ClockDivisor[] = {
+    I2C1_BAUD_DIVISOR(100000UL),
+    I2C1_BAUD_DIVISOR(400000UL),
+    I2C1_BAUD_DIVISOR(1000000UL)
+};
+
+// Queued transaction descriptors; head is only written by the submitter, tail and done only
+// by the engine (SSP1 interrupt), reported only by I2C1_Tasks(). A slot is reused once reported.
+static i2c1_transaction_t *i2c1Queue[I2C1_QUEUE_SIZE];
+static i2c1_error_t i2c1QueueError[I2C1_QUEUE_SIZE];
+static volatile uint8_t i2c1QueueHead = 0;
+static volatile uint8_t i2c1QueueTail = 0;
+static volatile uint8_t i2c1QueueDone = 0;
+static uint8_t i2c1QueueReported = 0;
 
 void I2C1_Initialize()
 {
     SSP1STAT = 0x00;
     SSP1CON1 = 0x08;
     SSP1CON2 = 0x00;
-    SSP1ADD  = 0x4F;
+    SSP1ADD  = i2c1ClockDivisor[I2C1_CLOCK_100KHZ];
     SSP1CON1bits.SSPEN = 0;
 }
 
 i2c1_error_t I2C1_Open(i2c1_address_t address)
 {
     i2c1_error_t returnValue = I2C1_BUSY;
+    bool state = INTCONbits.GIE;
+    bool available;
     
-    if(!I2C1_Status.inUse)
+    // the SSP1 interrupt opens the bus for queued transactions
+    INTCONbits.GIE = 0;
+    available = !I2C1_Status.inUse;
+    I2C1_Status.inUse = 1;
+    INTCONbits.GIE = state;
+
+    if(available)
     {
         I2C1_Status.address = address;
         I2C1_Status.busy = 0;
         I2C1_Status.inUse = 1;
+        I2C1_Status.interruptDriven = 0;
+        I2C1_Status.error = I2C1_NOERR;
         I2C1_Status.addressNackCheck = 0;
         I2C1_Status.state = I2C1_RESET;
         I2C1_Status.time_out_value = 500; // MCC should determine a reasonable starting value here.
@@ -216,7 +267,13 @@ i2c1_error_t I2C1_Close(void)
         I2C1_MasterClearIrq();
         I2C1_MasterDisableIrq();
         I2C1_MasterClose();
+        i2c1BusTime += TMR0_ReadTimestamp() - i2c1BusStart;
         returnValue = I2C1_Status.error;
+        // hand the bus to the next queued transaction, if any, from the SSP1 interrupt
+        if(i2c1QueueHead != i2c1QueueTail)
+        {
+            I2C1_MasterKick();
+        }
     }
     return returnValue;
 }
@@ -237,12 +294,129 @@ i2c1_error_t I2C1_MasterOperation(bool read)
         {
             I2C1_Status.state = I2C1_SEND_ADR_WRITE;
         }
+        i2c1TransactionCount++;
+        i2c1BusStart = TMR0_ReadTimestamp();
         I2C1_MasterStart();
-        I2C1_Poller();
+        if(I2C1_Status.interruptDriven)
+        {
+            I2C1_MasterEnableIrq();
+        }
+        else
+        {
+            I2C1_Poller();
+        }
     }
     return returnValue;
 }
 
+i2c1_error_t I2C1_SubmitTransaction(i2c1_transaction_t *transaction)
+{
+    return I2C1_SubmitBatch(&transaction, 1);
+}
+
+i2c1_error_t I2C1_SubmitBatch(i2c1_transaction_t * const *transactions, uint8_t count)
+{
+    i2c1_error_t error = I2C1_BUSY;
+    bool state = INTCONbits.GIE;
+    uint8_t head;
+    uint8_t index;
+
+    // the SSP1 interrupt advances the queue; keep the room check and publish atomic
+    INTCONbits.GIE = 0;
+    head = i2c1QueueHead;
+    if((uint8_t)(I2C1_QUEUE_SIZE - (uint8_t)(head - i2c1QueueReported)) >= count)
+    {
+        error = I2C1_NOERR;
+        // a descriptor still queued or on the bus is not queued twice
+        for(index = 0; index < count; index++)
+        {
+            if(I2C1_IsQueued(transactions[index]))
+            {
+                error = I2C1_BUSY;
+            }
+        }
+    }
+    if(error == I2C1_NOERR)
+    {
+        while(count--)
+        {
+            i2c1Queue[head & I2C1_QUEUE_MASK] = *transactions++;
+            head++;
+        }
+        // publish the whole batch at once so it runs back-to-back
+        i2c1QueueHead = head;
+
+        if(!I2C1_Status.inUse)
+        {
+            I2C1_MasterKick();
+        }
+    }
+    INTCONbits.GIE = state;
+    return error;
+}
+
+void I2C1_Tasks(void)
+{
+    i2c1_transaction_t *transaction;
+    i2c1_error_t error;
+    bool state = INTCONbits.GIE;
+
+    INTCONbits.GIE = 0;
+    if(I2C1_Status.inUse && I2C1_Status.interruptDriven && I2C1_Status.busy
+        && ((uint16_t)(TMR0_ReadTimestamp() - i2c1BusStart) > I2C1_TIMEOUT_TICKS))
+    {
+        // SCL held low or no SSP1 event; disabling the MSSP releases SCL and SDA
+        I2C1_MasterClose();
+        I2C1_Status.busy = false;
+        I2C1_Status.error = I2C1_FAIL;
+        I2C1_TransactionFinished(I2C1_FAIL);
+        I2C1_Close();
+    }
+    INTCONbits.GIE = state;
+
+    // completions are reported here, outside of the SSP1 interrupt
+    while(i2c1QueueReported != i2c1QueueDone)
+    {
+        transaction = i2c1Queue[i2c1QueueReported & I2C1_QUEUE_MASK];
+        error = i2c1QueueError[i2c1QueueReported & I2C1_QUEUE_MASK];
+        // the slot is free again, the callback may queue the descriptor anew
+        i2c1QueueReported++;
+        if(transaction->complete)
+        {
+            transaction->complete(error, transaction->payload);
+        }
+    }
+}
+
+void I2C1_ISR(void)
+{
+    if(!I2C1_Status.inUse)
+    {
+        // kicked by I2C1_SubmitBatch() or I2C1_Close(), start the next queued transaction
+        I2C1_MasterClearIrq();
+        I2C1_MasterDisableIrq();
+        I2C1_StartNextTransaction();
+        return;
+    }
+
+    I2C1_MasterFsm();
+
+    if(!I2C1_Status.busy)
+    {
+        // STOP has completed; the owner is notified from I2C1_Tasks()
+        I2C1_TransactionFinished(I2C1_Status.error);
+        I2C1_Close();
+    }
+}
+
+void I2C1_Poll(void)
+{
+    if(!INTCONbits.GIE && PIR3bits.SSP1IF && I2C1_MasterIsIrqEnabled())
+    {
+        I2C1_ISR();
+    }
+}
+
 i2c1_error_t I2C1_MasterRead(void)
 {
     return I2C1_MasterOperation(true);
@@ -295,6 +469,43 @@ void I2C1_SetTimeoutCallback(i2c1_callback_t cb, void *ptr)
     I2C1_SetCallback(I2C1_TIMEOUT, cb, ptr);
 }
 
+uint16_t I2C1_GetTransactionCount(void)
+{
+    return i2c1TransactionCount;
+}
+
+void I2C1_ClearTransactionCount(void)
+{
+    i2c1TransactionCount = 0;
+}
+
+void I2C1_SetClock(i2c1_clock_t clock)
+{
+    i2c1Clock = clock;
+}
+
+i2c1_clock_t I2C1_GetClock(void)
+{
+    return i2c1Clock;
+}
+
+uint16_t I2C1_GetBusTime(void)
+{
+    return i2c1BusTime;
+}
+
+void I2C1_ClearBusTime(void)
+{
+    i2c1BusTime = 0;
+}
+
+static void I2C1_ApplyClock(i2c1_clock_t clock)
+{
+    SSP1ADD = i2c1ClockDivisor[clock];
+    // slew rate control is only used in fast mode
+    SSP1STATbits.SMP = (clock != I2C1_CLOCK_400KHZ);
+}
+
 static void I2C1_SetCallback(i2c1_callbackIndex_t idx, i2c1_callback_t cb, void *ptr)
 {
     if(cb)
@@ -318,6 +529,80 @@ static void I2C1_Poller(void)
     }
 }
 
+static void I2C1_StartNextTransaction(void)
+{
+    i2c1_transaction_t *transaction;
+
+    if((i2c1QueueHead != i2c1QueueTail) && (I2C1_NOERR == I2C1_Open(i2c1Queue[i2c1QueueTail & I2C1_QUEUE_MASK]->address)))
+    {
+        transaction = i2c1Queue[i2c1QueueTail & I2C1_QUEUE_MASK];
+        i2c1QueueTail++;
+        I2C1_ApplyClock(transaction->clock);
+        I2C1_Status.interruptDriven = 1;
+        I2C1_SetDataCompleteCallback(I2C1_TransactionRegisterSent, transaction);
+        I2C1_SetBuffer(&transaction->reg, 1);
+        I2C1_MasterWrite();
+    }
+}
+
+static void I2C1_TransactionFinished(i2c1_error_t error)
+{
+    // transactions finish in queue order
+    i2c1QueueError[i2c1QueueDone & I2C1_QUEUE_MASK] = error;
+    i2c1QueueDone++;
+}
+
+static bool I2C1_IsQueued(const i2c1_transaction_t *transaction)
+{
+    uint8_t index;
+
+    // queued, on the bus, or finished but not reported yet
+    for(index = i2c1QueueReported; index != i2c1QueueHead; index++)
+    {
+        if(i2c1Queue[index & I2C1_QUEUE_MASK] == transaction)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static i2c1_operations_t I2C1_TransactionRegisterSent(void *ptr)
+{
+    i2c1_transaction_t *transaction = ptr;
+
+    if(0 == transaction->length)
+    {
+        // register pointer write only
+        return I2C1_TransactionDataSent(transaction);
+    }
+    I2C1_SetBuffer(transaction->data, transaction->length);
+    I2C1_SetDataCompleteCallback(I2C1_TransactionDataSent, transaction);
+    return (transaction->read) ? I2C1_RESTART_READ : I2C1_CONTINUE;
+}
+
+static i2c1_operations_t I2C1_TransactionDataSent(void *ptr)
+{
+    i2c1_transaction_t *next;
+
+    if(i2c1QueueHead == i2c1QueueTail)
+    {
+        // last queued transaction; STOP, it finishes in I2C1_ISR()
+        I2C1_SetDataCompleteCallback(NULL, NULL);
+        return I2C1_STOP;
+    }
+
+    // chain the next descriptor with a repeated start, no STOP/START in between
+    next = i2c1Queue[i2c1QueueTail & I2C1_QUEUE_MASK];
+    i2c1QueueTail++;
+    I2C1_Status.address = next->address;
+    I2C1_ApplyClock(next->clock);
+    I2C1_SetBuffer(&next->reg, 1);
+    I2C1_SetDataCompleteCallback(I2C1_TransactionRegisterSent, next);
+    I2C1_TransactionFinished(I2C1_NOERR);
+    return I2C1_RESTART_WRITE;
+}
+
 static inline void I2C1_MasterFsm(void)
 {
     I2C1_MasterClearIrq();
@@ -332,8 +617,8 @@ static inline void I2C1_MasterFsm(void)
 
 static i2c1_fsm_states_t I2C1_DO_IDLE(void)
 {
+    // error is cleared by I2C1_Open(), keep an address NACK visible to I2C1_Close()
     I2C1_Status.busy = false;
-    I2C1_Status.error = I2C1_NOERR;
     return I2C1_RESET;
 }
 
@@ -389,6 +674,8 @@ static i2c1_fsm_states_t I2C1_DO_RX(void)
         switch(I2C1_Status.callbackTable[I2C1_DATA_COMPLETE](I2C1_Status.callbackPayload[I2C1_DATA_COMPLETE]))
         {
             case I2C1_RESTART_WRITE:
+                I2C1_MasterSendNack();
+                return I2C1_SEND_RESTART_WRITE;
             case I2C1_RESTART_READ:
                 return I2C1_DO_RX_NACK_RESTART();
             default:
@@ -412,8 +699,9 @@ static i2c1_fsm_states_t I2C1_DO_TX_EMPTY(void)
     switch(I2C1_Status.callbackTable[I2C1_DATA_COMPLETE](I2C1_Status.callbackPayload[I2C1_DATA_COMPLETE]))
     {
         case I2C1_RESTART_READ:
+            return I2C1_DO_SEND_RESTART_READ();
         case I2C1_RESTART_WRITE:
-            return I2C1_DO_SEND_RESTART();
+            return I2C1_DO_SEND_RESTART_WRITE();
         case I2C1_CONTINUE:
             I2C1_MasterSetIrq();
             return I2C1_TX;
@@ -547,7 +835,7 @@ static inline bool I2C1_MasterOpen(void)
         SSP1STAT = 0x00;
         SSP1CON1 = 0x08;
         SSP1CON2 = 0x00;
-        SSP1ADD = 0x4F;
+        I2C1_ApplyClock(i2c1Clock);
         SSP1CON1bits.SSPEN = 1;
         return true;
     }
@@ -647,6 +935,13 @@ static inline void I2C1_MasterSetIrq(void)
     PIR3bits.SSP1IF = 1;
 }
 
+static inline void I2C1_MasterKick(void)
+{
+    // queued transactions are only started from the SSP1 interrupt
+    I2C1_MasterSetIrq();
+    I2C1_MasterEnableIrq();
+}
+
 static inline void I2C1_MasterWaitForEvent(void)
 {
     while(1)
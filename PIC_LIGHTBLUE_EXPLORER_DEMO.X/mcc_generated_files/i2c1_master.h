@@ -72,8 +72,33 @@ typedef enum
     I2C1_RESET_LINK
 } i2c1_operations_t;
 
+typedef enum
+{
+    I2C1_CLOCK_100KHZ,  // Standard mode
+    I2C1_CLOCK_400KHZ,  // Fast mode
+    I2C1_CLOCK_1MHZ     // Fast mode plus
+} i2c1_clock_t;
+
 typedef uint8_t i2c1_address_t;
 typedef i2c1_operations_t (*i2c1_callback_t)(void *funPtr);
+typedef void (*i2c1_transaction_callback_t)(i2c1_error_t error, void *ptr);
+
+/**
+ * I2C1 register transaction descriptor used by the interrupt driven API.
+ * The register address is written first, followed by a repeated start and
+ * the read data phase, or directly by the write data phase.
+ */
+typedef struct
+{
+    i2c1_address_t address;                 // The slave address
+    i2c1_clock_t clock;                     // Bus clock used while this transaction runs
+    uint8_t reg;                            // Register address sent before the data phase
+    bool read;                              // true - read data phase, false - write data phase
+    uint8_t *data;                          // Data buffer of the data phase
+    size_t length;                          // Bytes in the data phase
+    i2c1_transaction_callback_t complete;   // Called from I2C1_Tasks() when finished, may be NULL
+    void *payload;                          // Parameter passed to the complete callback
+} i2c1_transaction_t;
 
 // common callback responses
 i2c1_operations_t I2C1_CallbackReturnStop(void *funPtr);
@@ -203,4 +228,133 @@ void I2C1_SetDataNackCallback(i2c1_callback_t cb, void *ptr);
  */
 void I2C1_SetTimeoutCallback(i2c1_callback_t cb, void *ptr);
 
+/**
+ * \brief Queue a register transaction driven from the SSP1 interrupt
+ *
+ * The descriptor is added to the I2C1 transaction queue and the call returns
+ * immediately. Queued transactions run back-to-back from I2C1_ISR(), linked
+ * with repeated starts, and the bus is released after the last one. Each
+ * descriptor complete callback is called from I2C1_Tasks(), in the main loop,
+ * once its data phase has finished. The descriptor and its data buffer must
+ * remain valid until the callback has been called.
+ *
+ * \param[in] transaction Pointer to the transaction descriptor
+ *
+ * \return Status of submit operation.
+ * \retval I2C1_NOERR The transaction was queued
+ * \retval I2C1_BUSY  The transaction was not queued, the queue is full
+ */
+i2c1_error_t I2C1_SubmitTransaction(i2c1_transaction_t *transaction);
+
+/**
+ * \brief Queue a batch of register transactions driven from the SSP1 interrupt
+ *
+ * All descriptors are queued together, or none of them is. The batch runs as
+ * one bus transaction: a single START, a repeated start between descriptors
+ * (address, register and direction may differ) and a single STOP.
+ * It is called from the main loop, not from an interrupt handler.
+ *
+ * \param[in] transactions Array of pointers to the transaction descriptors
+ * \param[in] count Number of descriptors in the array
+ *
+ * \return Status of submit operation.
+ * \retval I2C1_NOERR The batch was queued
+ * \retval I2C1_BUSY  The batch was not queued, not enough room in the queue or
+ *                    a descriptor is still queued or on the bus
+ */
+i2c1_error_t I2C1_SubmitBatch(i2c1_transaction_t * const *transactions, uint8_t count);
+
+/**
+ * \brief Report and supervise the queued transactions, called from the main loop
+ *
+ * The SSP1 interrupt only runs the bus and records the status of each finished
+ * transaction; the complete callbacks are called from here, in queue order.
+ * A queued bus transaction still running after I2C1_TRANSACTION_TIMEOUT ms,
+ * because a slave holds SCL low or an SSP1 event never came, is aborted: the
+ * MSSP is disabled, which releases the bus, and the transaction completes
+ * with I2C1_FAIL. The next queued transaction is then started.
+ *
+ * \return Nothing
+ */
+void I2C1_Tasks(void);
+
+/**
+ * \brief Service the queued transactions while global interrupts are disabled
+ *
+ * Runs I2C1_ISR() for a pending SSP1 event when the interrupt cannot be taken,
+ * e.g. during initialization. Does nothing when global interrupts are enabled.
+ *
+ * \return Nothing
+ */
+void I2C1_Poll(void);
+
+/**
+ * \brief I2C1 (SSP1) interrupt service routine
+ *
+ * Advances the I2C1 state machine by one bus event, or starts the next queued
+ * transaction once the bus is free. Called by the interrupt manager for
+ * transactions queued with I2C1_SubmitTransaction(); no complete callback is
+ * called from here.
+ *
+ * \return Nothing
+ */
+void I2C1_ISR(void);
+
+/**
+ * \brief Get the number of I2C1 transactions started since the last clear.
+ *
+ * A transaction is counted for every START condition issued by
+ * I2C1_MasterOperation(); repeated starts inside the same transaction are
+ * not counted. Used to measure the bus cost of the sensor drivers.
+ *
+ * \return Number of transactions started
+ */
+uint16_t I2C1_GetTransactionCount(void);
+
+/**
+ * \brief Reset the I2C1 transaction counter to zero.
+ *
+ * \return Nothing
+ */
+void I2C1_ClearTransactionCount(void);
+
+/**
+ * \brief Select the bus clock used by I2C1_Open() based transfers.
+ *
+ * Transactions queued with I2C1_SubmitTransaction() use the clock of their
+ * descriptor instead. The baud divisors are computed from _XTAL_FREQ at
+ * compile time. The new clock is applied on the next I2C1_Open().
+ *
+ * \param[in] clock The bus clock
+ *
+ * \return Nothing
+ */
+void I2C1_SetClock(i2c1_clock_t clock);
+
+/**
+ * \brief Get the bus clock used by I2C1_Open() based transfers.
+ *
+ * \return The bus clock selected with I2C1_SetClock()
+ */
+i2c1_clock_t I2C1_GetClock(void);
+
+/**
+ * \brief Get the time the I2C1 bus was held since the last clear.
+ *
+ * Accumulates the time from each START condition to the release of the bus
+ * in I2C1_Close(), chained transactions included, in TMR0 counts (16 us per
+ * count with the TMR0 configuration of this project). Used together with
+ * I2C1_GetTransactionCount() to measure the bus cost of the sensor drivers.
+ *
+ * \return Bus time in TMR0 counts
+ */
+uint16_t I2C1_GetBusTime(void);
+
+/**
+ * \brief Reset the I2C1 bus time to zero.
+ *
+ * \return Nothing
+ */
+void I2C1_ClearBusTime(void);
+
 #endif //I2C1_MASTER_H
\ No newline at end of file
@@ -49,39 +49,108 @@
 #include "interrupt_manager.h"
 #include "mcc.h"
 
-void __interrupt() INTERRUPT_InterruptManager (void)
+/**
+  Section: Data Type Definitions
+*/
+
+typedef struct
+{
+    volatile uint8_t *enableRegister;
+    volatile uint8_t *flagRegister;
+    uint8_t mask;
+    uint8_t priority;
+    void (*handler)(void);
+} interrupt_source_t;
+
+/**
+  Section: Global Variables
+*/
+
+static interrupt_source_t interruptSources[INTERRUPT_SOURCE_COUNT];
+static uint8_t interruptSourceCount = 0;
+
+/**
+  Section: Built-in Source Handlers
+*/
+
+// forward to the handlers the drivers install at runtime
+static void INTERRUPT_Eusart2Rx(void)
+{
+    EUSART2_RxDefaultInterruptHandler();
+}
+
+static void INTERRUPT_Eusart2Tx(void)
+{
+    EUSART2_TxDefaultInterruptHandler();
+}
+
+static void INTERRUPT_Eusart1Rx(void)
+{
+    EUSART1_RxDefaultInterruptHandler();
+}
+
+static void INTERRUPT_Eusart1Tx(void)
 {
-    // interrupt handler
-    if(PIE0bits.IOCIE == 1 && PIR0bits.IOCIF == 1)
+    EUSART1_TxDefaultInterruptHandler();
+}
+
+void INTERRUPT_Initialize(void)
+{
+    INTERRUPT_RegisterSource(&PIE3, &PIR3, _PIE3_RC2IE_MASK, INTERRUPT_PRIORITY_EUSART2_RX, INTERRUPT_Eusart2Rx);
+    INTERRUPT_RegisterSource(&PIE3, &PIR3, _PIE3_RC1IE_MASK, INTERRUPT_PRIORITY_EUSART1_RX, INTERRUPT_Eusart1Rx);
+    INTERRUPT_RegisterSource(&PIE0, &PIR0, _PIE0_IOCIE_MASK, INTERRUPT_PRIORITY_IOC, PIN_MANAGER_IOC);
+    INTERRUPT_RegisterSource(&PIE3, &PIR3, _PIE3_TX2IE_MASK, INTERRUPT_PRIORITY_EUSART2_TX, INTERRUPT_Eusart2Tx);
+    INTERRUPT_RegisterSource(&PIE3, &PIR3, _PIE3_TX1IE_MASK, INTERRUPT_PRIORITY_EUSART1_TX, INTERRUPT_Eusart1Tx);
+    INTERRUPT_RegisterSource(&PIE3, &PIR3, _PIE3_SSP1IE_MASK, INTERRUPT_PRIORITY_SSP1, I2C1_ISR);
+}
+
+bool INTERRUPT_RegisterSource(volatile uint8_t *enableRegister, volatile uint8_t *flagRegister, uint8_t mask, uint8_t priority, void (*handler)(void))
+{
+    uint8_t index;
+    bool state = INTCONbits.GIE;
+
+    if(INTERRUPT_SOURCE_COUNT <= interruptSourceCount)
     {
-        PIN_MANAGER_IOC();
+        return false;
     }
-    else if(INTCONbits.PEIE == 1)
+
+    INTERRUPT_GlobalInterruptDisable();
+    // keep the table sorted by priority, after the sources of equal priority
+    index = interruptSourceCount++;
+    while((0 < index) && (interruptSources[index - 1].priority > priority))
     {
-        if(PIE3bits.TX2IE == 1 && PIR3bits.TX2IF == 1)
-        {
-            EUSART2_TxDefaultInterruptHandler();
-        } 
-        else if(PIE3bits.RC2IE == 1 && PIR3bits.RC2IF == 1)
-        {
-            EUSART2_RxDefaultInterruptHandler();
-        } 
-        else if(PIE3bits.TX1IE == 1 && PIR3bits.TX1IF == 1)
-        {
-            EUSART1_TxDefaultInterruptHandler();
-        } 
-        else if(PIE3bits.RC1IE == 1 && PIR3bits.RC1IF == 1)
+        interruptSources[index] = interruptSources[index - 1];
+        index--;
+    }
+    interruptSources[index].enableRegister = enableRegister;
+    interruptSources[index].flagRegister = flagRegister;
+    interruptSources[index].mask = mask;
+    interruptSources[index].priority = priority;
+    interruptSources[index].handler = handler;
+    INTCONbits.GIE = state;
+
+    return true;
+}
+
+void __interrupt() INTERRUPT_InterruptManager (void)
+{
+    uint8_t index = 0;
+    interrupt_source_t *source;
+
+    // serve every pending source, restarting from the highest priority after each one
+    while(index < interruptSourceCount)
+    {
+        source = &interruptSources[index];
+        if((*source->enableRegister & source->mask) && (*source->flagRegister & source->mask)
+            && (INTCONbits.PEIE || (source->enableRegister == &PIE0)))
         {
-            EUSART1_RxDefaultInterruptHandler();
-        } 
+            source->handler();
+            index = 0;
+        }
         else
         {
-            //Unhandled Interrupt
+            index++;
         }
-    }      
-    else
-    {
-        //Unhandled Interrupt
     }
 }
 /**
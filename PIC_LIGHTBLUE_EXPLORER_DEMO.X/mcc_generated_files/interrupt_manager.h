@@ -49,6 +49,36 @@
 #ifndef INTERRUPT_MANAGER_H
 #define INTERRUPT_MANAGER_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+  Section: Macro Declarations
+*/
+
+// maximum number of sources served by INTERRUPT_InterruptManager
+#define INTERRUPT_SOURCE_COUNT          8
+
+// dispatch priorities of the built-in sources, 0 is served first
+#ifndef INTERRUPT_PRIORITY_EUSART2_RX
+#define INTERRUPT_PRIORITY_EUSART2_RX   0
+#endif
+#ifndef INTERRUPT_PRIORITY_EUSART1_RX
+#define INTERRUPT_PRIORITY_EUSART1_RX   1
+#endif
+#ifndef INTERRUPT_PRIORITY_IOC
+#define INTERRUPT_PRIORITY_IOC          2
+#endif
+#ifndef INTERRUPT_PRIORITY_EUSART2_TX
+#define INTERRUPT_PRIORITY_EUSART2_TX   3
+#endif
+#ifndef INTERRUPT_PRIORITY_EUSART1_TX
+#define INTERRUPT_PRIORITY_EUSART1_TX   4
+#endif
+#ifndef INTERRUPT_PRIORITY_SSP1
+#define INTERRUPT_PRIORITY_SSP1         5
+#endif
+
 
 /**
  * @Param
@@ -97,6 +127,39 @@
  */
 #define INTERRUPT_PeripheralInterruptDisable() (INTCONbits.PEIE = 0)
 
+/**
+ * @Param
+    none
+ * @Returns
+    none
+ * @Description
+    Registers the IOC, EUSART1, EUSART2 and MSSP1 interrupt sources with
+    their INTERRUPT_PRIORITY_xxx dispatch priority.
+ * @Example
+    INTERRUPT_Initialize();
+ */
+void INTERRUPT_Initialize(void);
+
+/**
+ * @Param
+    enableRegister - interrupt enable register of the source (PIEx)
+    flagRegister - interrupt flag register of the source (PIRx)
+    mask - bit of the source in both registers
+    priority - dispatch priority, lower values are served first
+    handler - function serving the source; it must clear the flag
+ * @Returns
+    true if the source was registered, false if the table is full
+ * @Description
+    Adds an interrupt source to INTERRUPT_InterruptManager. Every interrupt
+    entry serves all pending sources, highest priority first, and rechecks
+    from the highest priority after each one. Sources in PIE0 are served
+    regardless of PEIE, the others only while PEIE is set. Sources of equal
+    priority are served in registration order.
+ * @Example
+    INTERRUPT_RegisterSource(&PIE0, &PIR0, _PIE0_TMR0IE_MASK, 6, MyTimerHandler);
+ */
+bool INTERRUPT_RegisterSource(volatile uint8_t *enableRegister, volatile uint8_t *flagRegister, uint8_t mask, uint8_t priority, void (*handler)(void));
+
 
 #endif  // INTERRUPT_MANAGER_H
 /**
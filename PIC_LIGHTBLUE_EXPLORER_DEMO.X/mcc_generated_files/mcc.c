@@ -56,6 +56,7 @@ void SYSTEM_Initialize(void)
     TMR0_Initialize();
     EUSART1_Initialize();
     EUSART2_Initialize();
+    INTERRUPT_Initialize();
 }
 
 void OSCILLATOR_Initialize(void)
@@ -52,6 +52,7 @@
 
 
 void (*IOCAF6_InterruptHandler)(void);
+void (*IOCCF2_InterruptHandler)(void);
 
 
 void PIN_MANAGER_Initialize(void)
@@ -119,11 +120,18 @@ void PIN_MANAGER_Initialize(void)
     IOCANbits.IOCAN6 = 0;
     //interrupt on change for group IOCAP - positive
     IOCAPbits.IOCAP6 = 1;
+    //interrupt on change for group IOCCF - flag
+    IOCCFbits.IOCCF2 = 0;
+    //interrupt on change for group IOCCN - negative
+    IOCCNbits.IOCCN2 = 0;
+    //interrupt on change for group IOCCP - positive
+    IOCCPbits.IOCCP2 = 0;
 
 
 
     // register default IOC callback functions at runtime; use these methods to register a custom function
     IOCAF6_SetInterruptHandler(IOCAF6_DefaultInterruptHandler);
+    IOCCF2_SetInterruptHandler(IOCCF2_DefaultInterruptHandler);
    
     // Enable IOCI interrupt 
     PIE0bits.IOCIE = 1; 
@@ -146,6 +154,11 @@ void PIN_MANAGER_IOC(void)
     {
         IOCAF6_ISR();  
     }	
+	// interrupt on change for pin IOCCF2
+    if(IOCCFbits.IOCCF2 == 1)
+    {
+        IOCCF2_ISR();  
+    }	
 }
 
 /**
@@ -178,6 +191,36 @@ void IOCAF6_DefaultInterruptHandler(void){
     // or set custom function using IOCAF6_SetInterruptHandler()
 }
 
+/**
+   IOCCF2 Interrupt Service Routine
+*/
+void IOCCF2_ISR(void) {
+
+    // Add custom IOCCF2 code
+
+    // Call the interrupt handler for the callback registered at runtime
+    if(IOCCF2_InterruptHandler)
+    {
+        IOCCF2_InterruptHandler();
+    }
+    IOCCFbits.IOCCF2 = 0;
+}
+
+/**
+  Allows selecting an interrupt handler for IOCCF2 at application runtime
+*/
+void IOCCF2_SetInterruptHandler(void (* InterruptHandler)(void)){
+    IOCCF2_InterruptHandler = InterruptHandler;
+}
+
+/**
+  Default interrupt handler for IOCCF2
+*/
+void IOCCF2_DefaultInterruptHandler(void){
+    // add your IOCCF2 interrupt custom code
+    // or set custom function using IOCCF2_SetInterruptHandler()
+}
+
 /**
  End of File
 */
\ No newline at end of file
@@ -193,6 +193,46 @@
 #define RB5_SetAnalogMode()         do { ANSELBbits.ANSB5 = 1; } while(0)
 #define RB5_SetDigitalMode()        do { ANSELBbits.ANSB5 = 0; } while(0)
 
+// get/set BT_CTS aliases
+#define BT_CTS_TRIS                    TRISCbits.TRISC2
+#define BT_CTS_LAT                     LATCbits.LATC2
+#define BT_CTS_PORT                    PORTCbits.RC2
+#define BT_CTS_WPU                     WPUCbits.WPUC2
+#define BT_CTS_OD                      ODCONCbits.ODCC2
+#define BT_CTS_ANS                     ANSELCbits.ANSC2
+#define BT_CTS_SetHigh()               do { LATCbits.LATC2 = 1; } while(0)
+#define BT_CTS_SetLow()                do { LATCbits.LATC2 = 0; } while(0)
+#define BT_CTS_Toggle()                do { LATCbits.LATC2 = ~LATCbits.LATC2; } while(0)
+#define BT_CTS_GetValue()              PORTCbits.RC2
+#define BT_CTS_SetDigitalInput()       do { TRISCbits.TRISC2 = 1; } while(0)
+#define BT_CTS_SetDigitalOutput()      do { TRISCbits.TRISC2 = 0; } while(0)
+#define BT_CTS_SetPullup()             do { WPUCbits.WPUC2 = 1; } while(0)
+#define BT_CTS_ResetPullup()           do { WPUCbits.WPUC2 = 0; } while(0)
+#define BT_CTS_SetPushPull()           do { ODCONCbits.ODCC2 = 0; } while(0)
+#define BT_CTS_SetOpenDrain()          do { ODCONCbits.ODCC2 = 1; } while(0)
+#define BT_CTS_SetAnalogMode()         do { ANSELCbits.ANSC2 = 1; } while(0)
+#define BT_CTS_SetDigitalMode()        do { ANSELCbits.ANSC2 = 0; } while(0)
+
+// get/set BT_RTS aliases
+#define BT_RTS_TRIS                    TRISCbits.TRISC3
+#define BT_RTS_LAT                     LATCbits.LATC3
+#define BT_RTS_PORT                    PORTCbits.RC3
+#define BT_RTS_WPU                     WPUCbits.WPUC3
+#define BT_RTS_OD                      ODCONCbits.ODCC3
+#define BT_RTS_ANS                     ANSELCbits.ANSC3
+#define BT_RTS_SetHigh()               do { LATCbits.LATC3 = 1; } while(0)
+#define BT_RTS_SetLow()                do { LATCbits.LATC3 = 0; } while(0)
+#define BT_RTS_Toggle()                do { LATCbits.LATC3 = ~LATCbits.LATC3; } while(0)
+#define BT_RTS_GetValue()              PORTCbits.RC3
+#define BT_RTS_SetDigitalInput()       do { TRISCbits.TRISC3 = 1; } while(0)
+#define BT_RTS_SetDigitalOutput()      do { TRISCbits.TRISC3 = 0; } while(0)
+#define BT_RTS_SetPullup()             do { WPUCbits.WPUC3 = 1; } while(0)
+#define BT_RTS_ResetPullup()           do { WPUCbits.WPUC3 = 0; } while(0)
+#define BT_RTS_SetPushPull()           do { ODCONCbits.ODCC3 = 0; } while(0)
+#define BT_RTS_SetOpenDrain()          do { ODCONCbits.ODCC3 = 1; } while(0)
+#define BT_RTS_SetAnalogMode()         do { ANSELCbits.ANSC3 = 1; } while(0)
+#define BT_RTS_SetDigitalMode()        do { ANSELCbits.ANSC3 = 0; } while(0)
+
 // get/set RC4 procedures
 #define RC4_SetHigh()            do { LATCbits.LATC4 = 1; } while(0)
 #define RC4_SetLow()             do { LATCbits.LATC4 = 0; } while(0)
@@ -346,6 +386,90 @@ extern void (*IOCAF6_InterruptHandler)(void);
 void IOCAF6_DefaultInterruptHandler(void);
 
 
+/**
+ * @Param
+    none
+ * @Returns
+    none
+ * @Description
+    Interrupt on Change Handler for the IOCCF2 pin functionality
+ * @Example
+    IOCCF2_ISR();
+ */
+void IOCCF2_ISR(void);
+
+/**
+  @Summary
+    Interrupt Handler Setter for IOCCF2 pin interrupt-on-change functionality
+
+  @Description
+    Allows selecting an interrupt handler for IOCCF2 at application runtime
+    
+  @Preconditions
+    Pin Manager intializer called
+
+  @Returns
+    None.
+
+  @Param
+    InterruptHandler function pointer.
+
+  @Example
+    PIN_MANAGER_Initialize();
+    IOCCF2_SetInterruptHandler(MyInterruptHandler);
+
+*/
+void IOCCF2_SetInterruptHandler(void (* InterruptHandler)(void));
+
+/**
+  @Summary
+    Dynamic Interrupt Handler for IOCCF2 pin
+
+  @Description
+    This is a dynamic interrupt handler to be used together with the IOCCF2_SetInterruptHandler() method.
+    This handler is called every time the IOCCF2 ISR is executed and allows any function to be registered at runtime.
+    
+  @Preconditions
+    Pin Manager intializer called
+
+  @Returns
+    None.
+
+  @Param
+    None.
+
+  @Example
+    PIN_MANAGER_Initialize();
+    IOCCF2_SetInterruptHandler(IOCCF2_InterruptHandler);
+
+*/
+extern void (*IOCCF2_InterruptHandler)(void);
+
+/**
+  @Summary
+    Default Interrupt Handler for IOCCF2 pin
+
+  @Description
+    This is a predefined interrupt handler to be used together with the IOCCF2_SetInterruptHandler() method.
+    This handler is called every time the IOCCF2 ISR is executed. 
+    
+  @Preconditions
+    Pin Manager intializer called
+
+  @Returns
+    None.
+
+  @Param
+    None.
+
+  @Example
+    PIN_MANAGER_Initialize();
+    IOCCF2_SetInterruptHandler(IOCCF2_DefaultInterruptHandler);
+
+*/
+void IOCCF2_DefaultInterruptHandler(void);
+
+
 
 #endif // PIN_MANAGER_H
 /**
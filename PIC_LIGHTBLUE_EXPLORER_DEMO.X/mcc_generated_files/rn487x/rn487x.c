@@ -23,15 +23,48 @@
     OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS 
     SOFTWARE.
 */
+#include <string.h>
 #include "rn487x.h"
 #include "rn487x_interface.h"
 #include "../mcc.h"
+#include "../drivers/uart.h"
 
 /**
  * \def STATUS_MESSAGE_DELIMITER
  * This macro provide a definition of the RN487X devices PRE/POST status message delimiter.
  */
 #define STATUS_MESSAGE_DELIMITER        ('%')
+/**
+ * \ingroup RN487X
+ * \def STATUS_KEYWORD_DONE
+ * This macro marks the keyword of the status message being received as classified.
+ */
+#define STATUS_KEYWORD_DONE             (0xFF)
+
+/**
+ * \def RN487X_CMD_QUEUE_MASK
+ * This macro provide the index mask of the command queue, RN487X_CMD_QUEUE_SIZE is a power of two.
+ */
+#define RN487X_CMD_QUEUE_MASK           (RN487X_CMD_QUEUE_SIZE - 1)
+
+/**
+ * \def RN487X_CMD_TIMEOUT_TICKS
+ * This macro provide RN487X_RESPONSE_TIMEOUT in TMR0 counts, the time a queued command waits for its response.
+ */
+#define RN487X_CMD_TIMEOUT_TICKS        ((uint16_t)((uint32_t)RN487X_RESPONSE_TIMEOUT * TMR0_TICK_FREQUENCY / 1000))
+
+/**
+ * \ingroup RN487X
+ * Queued command
+ */
+typedef struct
+{
+    uint8_t cmd[RN487X_CMD_MAX_SIZE];   /**< Command bytes, followed by the raw value bytes */
+    uint8_t cmdLen;                     /**< Command length, without the value */
+    uint8_t valueLen;                   /**< Value length, the value is sent as hex followed by CR LF */
+    rn487x_cmd_response_t response;     /**< Response ending the command */
+    rn487x_cmd_callback_t complete;     /**< Completion callback */
+}rn487x_queued_cmd_t;
 
 uint8_t cmdBuf[64];                                 /**< Command TX Buffer */
 
@@ -42,6 +75,54 @@ static uint8_t asyncBufferSize;                     /**< Size of the Async Messa
 static char *pHead;                                 /**< Pointer to the Head of the Async Message Buffer */
 static uint8_t peek = 0;                            /**< Recieved Non-Status Message Data */
 static bool dataReady = false;                      /**< Flag which indicates whether Non-Status Message Data is ready */
+static bool asyncBuffering = false;                 /**< Flag which indicates a Status Message is being received */
+static RN487X_STATUS_t statusType;                  /**< Classification of the Status Message being received */
+static uint8_t statusFirst;                         /**< First keyword still matching the Status Message being received */
+static uint8_t statusLast;                          /**< One past the last keyword still matching the Status Message being received */
+static uint8_t statusIndex;                         /**< Keyword characters matched so far, STATUS_KEYWORD_DONE once classified */
+static volatile bool asyncPending = false;          /**< Flag which indicates a Status Message filtered by the bridge awaits RN487X_BridgeTasks() */
+static bool bridgeMode = false;                     /**< Flag which indicates the UARTs are bridged from the interrupts */
+static volatile bool rebootReceived = false;        /**< Flag which indicates a %REBOOT% Status Message was received */
+
+/**< Status Message keywords, indexed by RN487X_STATUS_t, in ASCII order */
+static const char * const statusKeyword[RN487X_STATUS_UNKNOWN] = {
+    "ADV_TIMEOUT",
+    "BONDED",
+    "CONNECT",
+    "CONN_PARAM",
+    "DISCONNECT",
+    "ERR_CONNPARAM",
+    "ERR_MEMORY",
+    "ERR_READ",
+    "ERR_RMT_CMD",
+    "ERR_SEC",
+    "INDI",
+    "KEY",
+    "KEY_REQ",
+    "NOTI",
+    "REBOOT",
+    "RMT_CMD_OFF",
+    "RMT_CMD_ON",
+    "SECURED",
+    "STREAM_OPEN",
+    "S_RUN",
+    "TMR1",
+    "TMR2",
+    "TMR3",
+    "WC",
+    "WV"
+};
+static const char * const cmdResponse[] = {"CMD> ", "END\r\n"};   /**< Indexed by rn487x_cmd_response_t */
+static const char cmdError[] = "Err";               /**< Error response of a command */
+static rn487x_queued_cmd_t cmdQueue[RN487X_CMD_QUEUE_SIZE];    /**< Asynchronous Command Queue */
+static uint8_t cmdHead = 0;                         /**< Command Queue write index */
+static uint8_t cmdTail = 0;                         /**< Command Queue read index, command in progress */
+static bool cmdActive = false;                      /**< Flag which indicates the command at cmdTail was sent */
+static uint8_t cmdMatch;                            /**< Matched length of the expected response */
+static uint8_t cmdErrorMatch;                       /**< Matched length of the error response */
+static bool cmdStatus;                              /**< Status of the command in progress */
+static uint16_t cmdStamp;                           /**< TMR0 timestamp of the command in progress, once sent */
+static bool cmdModeHeld = false;                    /**< Flag which indicates RN487X stays in command mode between queued commands */
 
 /**
  * \brief This function filters status messages from RN487X data.
@@ -51,6 +132,195 @@ static bool dataReady = false;                      /**< Flag which indicates wh
  */
 static bool RN487X_FilterData(void);
 
+/**
+ * \brief This function starts buffering a status message, after its opening delimiter.
+ * \param void This function takes no params.
+ * \return Nothing
+ */
+static void RN487X_StartStatus(void);
+
+/**
+ * \brief This function buffers a status message byte and classifies the message.
+ * The keyword is matched as it arrives, narrowing the range of statusKeyword entries
+ * sharing the received prefix, so the message is classified once it ends.
+ * \param readChar Byte received from the RN487X.
+ * \return a boolean value
+ * \retval true if readChar closed the status message; false otherwise.
+ */
+static bool RN487X_BufferStatus(uint8_t readChar);
+
+/**
+ * \brief This function ends the keyword of the status message being received.
+ * \param void This function takes no params.
+ * \return Nothing
+ */
+static void RN487X_EndStatusKeyword(void);
+
+/**
+ * \brief This function adds a command to the queue.
+ * \param cmd RN487X command.
+ * \param cmdLen RN487X command length.
+ * \param value Value bytes sent as hex after the command, may be NULL.
+ * \param valueLen Value length, 0 for none.
+ * \param response Response ending the command.
+ * \param complete Called once the response has been received, may be NULL.
+ * \return a boolean value
+ * \retval true if the command was queued; false if the queue is full or the command too long.
+ */
+static bool RN487X_EnqueueCmd(const uint8_t *cmd, uint8_t cmdLen, const uint8_t *value, uint8_t valueLen, rn487x_cmd_response_t response, rn487x_cmd_callback_t complete);
+
+/**
+ * \brief This function queues a command performed from command mode, between $$$ and --- unless command mode is held.
+ * \param cmd RN487X command.
+ * \param cmdLen RN487X command length.
+ * \param value Value bytes sent as hex after the command, may be NULL.
+ * \param valueLen Value length, 0 for none.
+ * \param complete Called with the command status, may be NULL.
+ * \return a boolean value
+ * \retval true if the commands were queued; false if the queue has no room for them.
+ */
+static bool RN487X_QueueInCmdMode(const uint8_t *cmd, uint8_t cmdLen, const uint8_t *value, uint8_t valueLen, rn487x_cmd_callback_t complete);
+
+/**
+ * \brief This function sends the next queued command, if any.
+ * \param void This function takes no params.
+ * \return Nothing
+ */
+static void RN487X_StartNextCmd(void);
+
+/**
+ * \brief This function fails the command in progress once it waited RN487X_RESPONSE_TIMEOUT for its response.
+ * The rest of its $$$ ... --- sequence is dropped up to the ---, which is still sent, and the next command started.
+ * \param void This function takes no params.
+ * \return Nothing
+ */
+static void RN487X_CheckCmdTimeout(void);
+
+/**
+ * \brief This function matches a received byte against the response of the command in progress.
+ * \param readChar Byte received from the RN487X.
+ * \return Nothing
+ */
+static void RN487X_MatchResponse(uint8_t readChar);
+
+/**
+ * \brief This function advances an incremental match of a message.
+ * \param msg Message to match.
+ * \param index Matched length so far.
+ * \param readChar Byte received from the RN487X.
+ * \return Matched length including readChar.
+ */
+static uint8_t RN487X_MatchMsg(const char *msg, uint8_t index, uint8_t readChar);
+
+/**
+ * \brief This function formats the |O command.
+ * \param cmd Buffer receiving the command.
+ * \param bitMap RN487X GPIO Output I/O & Low/High State
+ * \return Command length.
+ */
+static uint8_t RN487X_FormatOutputsCmd(uint8_t *cmd, rn487x_gpio_bitmap_t bitMap);
+
+/**
+ * \brief This function formats the T command.
+ * \param cmd Buffer receiving the command.
+ * \param param Connection parameters, in the order they are sent.
+ * \return Command length.
+ */
+static uint8_t RN487X_FormatConnParamsCmd(uint8_t *cmd, const uint16_t *param);
+
+/**
+ * \brief This function reads a response line, waiting at most RN487X_RESPONSE_TIMEOUT per character.
+ * \param line Buffer receiving the NUL terminated line, CR LF included; longer lines are truncated.
+ * \param size Size of the buffer.
+ * \return Line length, 0 on timeout.
+ */
+static uint8_t RN487X_ReadLine(char *line, uint8_t size);
+
+/**
+ * \brief This function waits for a response, skipping any other data.
+ * \param response Expected response.
+ * \param timeout Time to wait for the response, in ms.
+ * \return a boolean value
+ * \retval true if the response was received; false on timeout.
+ */
+static bool RN487X_WaitForResponse(const char *response, uint16_t timeout);
+
+/**
+ * \brief This function forwards RN487X data to the CDC UART, filtering status messages.
+ * Runs from the interrupts while bridging; stops at a filtered status message until
+ * RN487X_BridgeTasks() has handled it, and when the CDC transmit ring is full.
+ * \param void This function takes no params.
+ * \return Nothing
+ */
+static void RN487X_BridgeToCdc(void);
+
+/**
+ * \brief This function forwards CDC UART data to the RN487X.
+ * Runs from the interrupts while bridging; stops when the RN487X transmit ring is full.
+ * \param void This function takes no params.
+ * \return Nothing
+ */
+static void RN487X_BridgeToBle(void);
+
+/**
+ * \brief RN487X UART receive interrupt handler while bridging.
+ * \param void This function takes no params.
+ * \return Nothing
+ */
+static void RN487X_BridgeBleRxISR(void);
+
+/**
+ * \brief RN487X UART transmit interrupt handler while bridging.
+ * \param void This function takes no params.
+ * \return Nothing
+ */
+static void RN487X_BridgeBleTxISR(void);
+
+/**
+ * \brief CDC UART receive interrupt handler while bridging.
+ * \param void This function takes no params.
+ * \return Nothing
+ */
+static void RN487X_BridgeCdcRxISR(void);
+
+/**
+ * \brief CDC UART transmit interrupt handler while bridging.
+ * \param void This function takes no params.
+ * \return Nothing
+ */
+static void RN487X_BridgeCdcTxISR(void);
+
+/**
+ * \brief This function checks that RN487X answers $$$ with the command prompt.
+ * \param void This function takes no params.
+ * \return a boolean value
+ * \retval true if RN487X is in command mode; false otherwise.
+ */
+static bool RN487X_ProbeCmdMode(void);
+
+/**
+ * \brief This function leaves command mode, waiting at most RN487X_RESPONSE_TIMEOUT.
+ * \param void This function takes no params.
+ * \return Nothing
+ */
+static void RN487X_LeaveCmdMode(void);
+
+/**
+ * \brief This function moves RN487X and the UART to another baud rate, from command mode.
+ * \param rate Baud rate to move to.
+ * \return a boolean value
+ * \retval true if RN487X answers at the new rate; false otherwise, the UART is then left at the new rate.
+ */
+static bool RN487X_ChangeBaudRate(RN487X_BAUD_RATES_t rate);
+
+/**
+ * \brief This function finds the baud rate RN487X answers at, and moves it back to the boot rate.
+ * \param bootRate Baud rate RN487X is moved back to.
+ * \return a boolean value
+ * \retval true if RN487X answers at the rate the UART uses on return; false if it answers at no rate.
+ */
+static bool RN487X_RecoverBaudRate(RN487X_BAUD_RATES_t bootRate);
+
 bool RN487X_Init(void)
 {
     // Set Application Mode
@@ -64,30 +334,52 @@ bool RN487X_Init(void)
 
     //Wakeup
     RN487X.IndicateRx(true);
-    //Wait while RN487X is booting up
-    RN487X.DelayMs(RN487X_STARTUP_DELAY);
+    //Wait while RN487X is booting up, the banner ends the boot
+    return RN487X_WaitForReboot(RN487X_STARTUP_DELAY);
+}
 
-    //Remove unread data sent by RN487x, if any
-    while (RN487X.DataReady())
+bool RN487X_WaitForReboot(uint16_t timeout)
+{
+    uint32_t limit = (uint32_t)timeout * TMR0_TICK_FREQUENCY / 1000;
+    uint32_t elapsed = 0;
+    uint16_t last;
+    uint16_t now;
+
+    if (asyncBuffer == NULL)
     {
-        RN487X.Read();
+        // the banner cannot be received, wait for the longest boot instead
+        RN487X.DelayMs(timeout);
+        while (RN487X.DataReady())
+        {
+            RN487X.Read();
+        }
+        return false;
     }
 
+    rebootReceived = false;
+    last = TMR0_ReadTimestamp();
+    while (rebootReceived == false)
+    {
+        // elapsed time, not idle time: a chattering RX line cannot hold the wait
+        now = TMR0_ReadTimestamp();
+        elapsed += (uint16_t)(now - last);
+        last = now;
+        if (elapsed >= limit)
+        {
+            return false;
+        }
+        if (RN487X_DataReady())
+        {
+            // no data is expected while booting
+            RN487X_Read();
+        }
+    }
     return true;
 }
 
 void RN487X_SendCmd(const uint8_t *cmd, uint8_t cmdLen)
 {
-    uint8_t index = 0;
-
-    while (index < cmdLen)
-    {
-        if (RN487X.TransmitDone())
-        {
-            RN487X.Write(cmd[index]);
-            index++;
-        }
-    }
+    RN487X.WriteBlock(cmd, cmdLen);
 }
 
 uint8_t RN487X_GetCmd(const char *getCmd, uint8_t getCmdLen, char *getCmdResp)
@@ -98,7 +390,12 @@ uint8_t RN487X_GetCmd(const char *getCmd, uint8_t getCmdLen, char *getCmdResp)
 
     do
     {
-        getCmdResp[index++] = RN487X.Read();
+        if (RN487X.ReadTimeout((uint8_t *) &getCmdResp[index], RN487X_RESPONSE_TIMEOUT) == false)
+        {
+            // the module went quiet before the end of the line
+            break;
+        }
+        index++;
     }
     while (getCmdResp[index - 1] != '\n');
 
@@ -112,8 +409,8 @@ bool RN487X_ReadMsg(const uint8_t *expectedMsg, uint8_t msgLen)
 
     for (index = 0; index < msgLen; index++)
     {
-        resp = RN487X.Read();
-        if (resp != expectedMsg[index])
+        if ((RN487X.ReadTimeout(&resp, RN487X_RESPONSE_TIMEOUT) == false)
+            || (resp != expectedMsg[index]))
         {
             return false;
         }
@@ -125,11 +422,16 @@ bool RN487X_ReadMsg(const uint8_t *expectedMsg, uint8_t msgLen)
 bool RN487X_ReadDefaultResponse(void)
 {
     uint8_t resp[3];
+    uint8_t index;
     bool status = false;
 
-    resp[0] = RN487X.Read();
-    resp[1] = RN487X.Read();
-    resp[2] = RN487X.Read();
+    for (index = 0; index < sizeof (resp); index++)
+    {
+        if (RN487X.ReadTimeout(&resp[index], RN487X_RESPONSE_TIMEOUT) == false)
+        {
+            return status;
+        }
+    }
 
     switch (resp[0])
     {
@@ -153,16 +455,14 @@ bool RN487X_ReadDefaultResponse(void)
         }
     }
 
-    /* Read carriage return and line feed comes with response */
-    RN487X.Read();
-    RN487X.Read();
-
-    //Read CMD>
-    RN487X.Read();
-    RN487X.Read();
-    RN487X.Read();
-    RN487X.Read();
-    RN487X.Read();
+    /* Read carriage return and line feed comes with response, then CMD> */
+    for (index = 0; index < (sizeof ("\r\nCMD> ") - 1); index++)
+    {
+        if (RN487X.ReadTimeout(&resp[0], RN487X_RESPONSE_TIMEOUT) == false)
+        {
+            break;
+        }
+    }
   
     return status;
 }
@@ -221,6 +521,12 @@ bool RN487X_EnterDataMode(void)
 }
 
 bool RN487X_SetOutputs(rn487x_gpio_bitmap_t bitMap)
+{
+    RN487X_SendCmd(cmdBuf, RN487X_FormatOutputsCmd(cmdBuf, bitMap));
+    return RN487X_ReadDefaultResponse();
+}
+
+static uint8_t RN487X_FormatOutputsCmd(uint8_t *cmd, rn487x_gpio_bitmap_t bitMap)
 {
     char ioHighNibble = '0';
     char ioLowNibble = '0';
@@ -249,19 +555,38 @@ bool RN487X_SetOutputs(rn487x_gpio_bitmap_t bitMap)
     }
     stateLowNibble = ( (0x0F & bitMap.ioStateBitMap.gpioStateBitMap) + '0');
 
-    cmdBuf[0] = '|';    // I/O
-    cmdBuf[1] = 'O';    // Output
-    cmdBuf[2] = ',';
-    cmdBuf[3] = ioHighNibble;       // - | - | - | P1_3
-    cmdBuf[4] = ioLowNibble;        // P1_2 | P3_5 | P2_4 | P2_2
-    cmdBuf[5] = ',';
-    cmdBuf[6] = stateHighNibble;    // - | - | - | P1_3
-    cmdBuf[7] = stateLowNibble;     // P1_2 | P3_5 | P2_4 | P2_2
-    cmdBuf[8] = '\r';
-    cmdBuf[9] = '\n';
+    cmd[0] = '|';    // I/O
+    cmd[1] = 'O';    // Output
+    cmd[2] = ',';
+    cmd[3] = ioHighNibble;       // - | - | - | P1_3
+    cmd[4] = ioLowNibble;        // P1_2 | P3_5 | P2_4 | P2_2
+    cmd[5] = ',';
+    cmd[6] = stateHighNibble;    // - | - | - | P1_3
+    cmd[7] = stateLowNibble;     // P1_2 | P3_5 | P2_4 | P2_2
+    cmd[8] = '\r';
+    cmd[9] = '\n';
 
-    RN487X_SendCmd(cmdBuf, 10);
-    return RN487X_ReadDefaultResponse();
+    return 10;
+}
+
+static uint8_t RN487X_FormatConnParamsCmd(uint8_t *cmd, const uint16_t *param)
+{
+    uint8_t index;
+    uint8_t length = 1;
+
+    cmd[0] = 'T';
+    for (index = 0; index < RN487X_CONN_PARAM_COUNT; index++)
+    {
+        cmd[length++] = ',';
+        cmd[length++] = NIBBLE2ASCII((param[index] >> 12) & 0x0F);
+        cmd[length++] = NIBBLE2ASCII((param[index] >> 8) & 0x0F);
+        cmd[length++] = NIBBLE2ASCII((param[index] >> 4) & 0x0F);
+        cmd[length++] = NIBBLE2ASCII(param[index] & 0x0F);
+    }
+    cmd[length++] = '\r';
+    cmd[length++] = '\n';
+
+    return length;
 }
 
 rn487x_gpio_stateBitMap_t RN487X_GetInputsValues(rn487x_gpio_ioBitMap_t getGPIOs)
@@ -304,8 +629,8 @@ bool RN487X_RebootCmd(void)
     cmdBuf[0] = 'R';
     cmdBuf[1] = ',';
     cmdBuf[2] = '1';
-    cmdBuf[4] = '\r';
-    cmdBuf[5] = '\n';
+    cmdBuf[3] = '\r';
+    cmdBuf[4] = '\n';
 
     RN487X_SendCmd(cmdBuf, 5);
 
@@ -325,72 +650,806 @@ bool RN487X_Disconnect(void)
     return RN487X_ReadDefaultResponse();
 }
 
-bool RN487X_SetAsyncMessageHandler(char* pBuffer, uint8_t len)
+bool RN487X_SetFlowControl(bool enable)
 {
-    if ((pBuffer != NULL) && (len > 1))
+    const uint8_t cmdPrompt[] = {'\r', '\n', 'C', 'M', 'D', '>', ' '};
+    uint16_t features = 0;
+    uint8_t index;
+    uint8_t resp;
+
+    if (RN487X_EnterCmdMode() == false)
     {
-      asyncBuffer = pBuffer;
-      asyncBufferSize = len - 1;
-      return true;
+        return false;
     }
-    else
+
+    cmdBuf[0] = 'G';
+    cmdBuf[1] = 'R';
+    cmdBuf[2] = '\r';
+    cmdBuf[3] = '\n';
+
+    RN487X_SendCmd(cmdBuf, 4);
+
+    // GR answers the features bitmap as (4) hex digits
+    for (index = 0; index < 4; index++)
+    {
+        if (RN487X.ReadTimeout(&resp, RN487X_RESPONSE_TIMEOUT) == false)
+        {
+            RN487X_EnterDataMode();
+            return false;
+        }
+        features = (features << 4) | RN487X_AsciiToNibble(resp);
+    }
+    if (RN487X_ReadMsg(cmdPrompt, sizeof (cmdPrompt)) == false)
     {
+        RN487X_EnterDataMode();
         return false;
     }
+
+    if (((features & RN487X_FEATURE_FLOW_CONTROL) != 0) == enable)
+    {
+        return RN487X_EnterDataMode();
+    }
+    features ^= RN487X_FEATURE_FLOW_CONTROL;
+
+    cmdBuf[0] = 'S';
+    cmdBuf[1] = 'R';
+    cmdBuf[2] = ',';
+    cmdBuf[3] = NIBBLE2ASCII((features >> 12) & 0x0F);
+    cmdBuf[4] = NIBBLE2ASCII((features >> 8) & 0x0F);
+    cmdBuf[5] = NIBBLE2ASCII((features >> 4) & 0x0F);
+    cmdBuf[6] = NIBBLE2ASCII(features & 0x0F);
+    cmdBuf[7] = '\r';
+    cmdBuf[8] = '\n';
+
+    RN487X_SendCmd(cmdBuf, 9);
+
+    if (RN487X_ReadDefaultResponse() == false)
+    {
+        RN487X_EnterDataMode();
+        return false;
+    }
+
+    // The features bitmap is applied by the reboot, which also leaves command mode
+    if (RN487X_RebootCmd() == false)
+    {
+        // no reboot confirmed, RN487X may still be in command mode
+        RN487X_EnterDataMode();
+        return false;
+    }
+    // with flow control just enabled RN487X may hold the banner, the timeout ends the wait
+    RN487X_WaitForReboot(RN487X_STARTUP_DELAY);
+
+    return true;
 }
 
-bool RN487X_DataReady(void)
+bool RN487X_NegotiateBaudRate(RN487X_BAUD_RATES_t target, RN487X_BAUD_RATES_t current)
 {
-    if (dataReady)
+    // The SB setting survives resets, RN487X may already run at the target rate
+    if (RN487X.SetBaudRate(target) == false)
+    {
+        // transmitter stalled (e.g. CTS held), the UART stays at the current rate
+        return false;
+    }
+    if (RN487X_ProbeCmdMode() == true)
     {
+        RN487X_LeaveCmdMode();
         return true;
     }
-    
-    if (RN487X.DataReady())
+
+    if (RN487X.SetBaudRate(current) == false)
     {
-        return RN487X_FilterData();
+        return false;
     }
-    return false;
+    if (RN487X_ProbeCmdMode() == false)
+    {
+        // An earlier negotiation may have saved a rate the UART cannot reach
+        return RN487X_RecoverBaudRate(current);
+    }
+
+    if (RN487X_ChangeBaudRate(target) == true)
+    {
+        return true;
+    }
+
+    // RN487X may have saved the target rate without answering at it
+    return RN487X_RecoverBaudRate(current);
 }
 
-uint8_t RN487X_Read(void)
+static bool RN487X_ChangeBaudRate(RN487X_BAUD_RATES_t rate)
 {
-    while(RN487X_DataReady() == false); // Wait
-    dataReady = false;
-    return peek;
+    cmdBuf[0] = 'S';
+    cmdBuf[1] = 'B';
+    cmdBuf[2] = ',';
+    cmdBuf[3] = NIBBLE2ASCII(rate >> 4);
+    cmdBuf[4] = NIBBLE2ASCII(rate & 0x0F);
+    cmdBuf[5] = '\r';
+    cmdBuf[6] = '\n';
+
+    RN487X_SendCmd(cmdBuf, 7);
+    if (RN487X_WaitForResponse("AOK", RN487X_RESPONSE_TIMEOUT) == false)
+    {
+        RN487X_LeaveCmdMode();
+        return false;
+    }
+
+    // The new rate is applied by the reboot, which also leaves command mode
+    RN487X_SendCmd((const uint8_t *) "R,1\r\n", 5);
+    RN487X_WaitForResponse("Rebooting\r\n", RN487X_RESPONSE_TIMEOUT);
+    if (RN487X.SetBaudRate(rate) == false)
+    {
+        return false;
+    }
+    RN487X_WaitForReboot(RN487X_STARTUP_DELAY);
+
+    if (RN487X_ProbeCmdMode() == false)
+    {
+        return false;
+    }
+    RN487X_LeaveCmdMode();
+    return true;
 }
 
-static bool RN487X_FilterData(void)
+static bool RN487X_RecoverBaudRate(RN487X_BAUD_RATES_t bootRate)
 {
-    static bool asyncBuffering = false;
-    
-    uint8_t readChar = RN487X.Read();
-    
-    if(asyncBuffering == true)
+    uint8_t rate;
+
+    for (rate = RN487X_BAUD_921600; rate <= RN487X_BAUD_9600; rate++)
     {
-        if(readChar == STATUS_MESSAGE_DELIMITER)
+        if (RN487X.SetBaudRate((RN487X_BAUD_RATES_t) rate) == false)
         {
-            asyncBuffering = false;
-            *pHead = '\0';
-            RN487X.AsyncHandler(asyncBuffer);
+            // transmitter stalled, no rate can be probed
+            return false;
         }
-        else if (pHead < asyncBuffer + asyncBufferSize)
+        if (RN487X_ProbeCmdMode() == false)
         {
-            *pHead++ = readChar;
+            continue;
         }
-    }
-    else
-    {
-        if (readChar == STATUS_MESSAGE_DELIMITER)
+        if (rate == bootRate)
         {
-            asyncBuffering = true;
-            pHead = asyncBuffer;
+            RN487X_LeaveCmdMode();
+            return true;
         }
-        else 
+        if (RN487X_ChangeBaudRate(bootRate) == true)
         {
-            dataReady = true;
-            peek = readChar;
+            return true;
+        }
+        // RN487X did not move back to the boot rate, go on at the rate found if it still answers
+        if ((RN487X.SetBaudRate((RN487X_BAUD_RATES_t) rate) == true) && (RN487X_ProbeCmdMode() == true))
+        {
+            RN487X_LeaveCmdMode();
+            return true;
         }
+        break;
     }
-    return dataReady;
+
+    // RN487X answers at no rate, leave the UART at the boot rate
+    RN487X.SetBaudRate(bootRate);
+    return false;
+}
+
+bool RN487X_SetServiceBitmap(uint8_t services)
+{
+    cmdBuf[0] = 'S';
+    cmdBuf[1] = 'S';
+    cmdBuf[2] = ',';
+    cmdBuf[3] = NIBBLE2ASCII(services >> 4);
+    cmdBuf[4] = NIBBLE2ASCII(services & 0x0F);
+    cmdBuf[5] = '\r';
+    cmdBuf[6] = '\n';
+
+    RN487X_SendCmd(cmdBuf, 7);
+
+    return RN487X_ReadDefaultResponse();
+}
+
+bool RN487X_ClearPrivateServices(void)
+{
+    RN487X_SendCmd((const uint8_t *) "PZ\r\n", 4);
+
+    return RN487X_ReadDefaultResponse();
+}
+
+bool RN487X_SetPrivateService(const char *uuid)
+{
+    uint8_t uuidLen = (uint8_t) strlen(uuid);
+
+    cmdBuf[0] = 'P';
+    cmdBuf[1] = 'S';
+    cmdBuf[2] = ',';
+    memcpy(&cmdBuf[3], uuid, uuidLen);
+    cmdBuf[3 + uuidLen] = '\r';
+    cmdBuf[4 + uuidLen] = '\n';
+
+    RN487X_SendCmd(cmdBuf, 5 + uuidLen);
+
+    return RN487X_ReadDefaultResponse();
+}
+
+bool RN487X_SetPrivateCharacteristic(const char *uuid, uint8_t properties, uint8_t size)
+{
+    uint8_t uuidLen = (uint8_t) strlen(uuid);
+    uint8_t *param = &cmdBuf[3 + uuidLen];
+
+    cmdBuf[0] = 'P';
+    cmdBuf[1] = 'C';
+    cmdBuf[2] = ',';
+    memcpy(&cmdBuf[3], uuid, uuidLen);
+    param[0] = ',';
+    param[1] = NIBBLE2ASCII(properties >> 4);
+    param[2] = NIBBLE2ASCII(properties & 0x0F);
+    param[3] = ',';
+    param[4] = NIBBLE2ASCII(size >> 4);
+    param[5] = NIBBLE2ASCII(size & 0x0F);
+    param[6] = '\r';
+    param[7] = '\n';
+
+    RN487X_SendCmd(cmdBuf, 11 + uuidLen);
+
+    return RN487X_ReadDefaultResponse();
+}
+
+uint8_t RN487X_GetCharacteristicHandles(const char * const *uuids, uint16_t *handles, uint8_t count)
+{
+    char *line = (char *) cmdBuf;
+    uint8_t found = 0;
+    uint8_t length;
+    uint8_t uuidLen;
+    uint8_t index;
+    uint8_t digit;
+
+    for (index = 0; index < count; index++)
+    {
+        handles[index] = 0;
+    }
+
+    RN487X_SendCmd((const uint8_t *) "LS\r\n", 4);
+
+    // Services are listed as "<UUID>", their characteristics as "  <UUID>,<handle>,<properties>",
+    // a notified characteristic is listed again with its configuration handle
+    do
+    {
+        length = RN487X_ReadLine(line, sizeof (cmdBuf));
+        if ((length < 2) || (line[0] != ' ') || (line[1] != ' '))
+        {
+            continue;
+        }
+        for (index = 0; index < count; index++)
+        {
+            uuidLen = (uint8_t) strlen(uuids[index]);
+            if ((handles[index] == 0)
+                && (strncmp(&line[2], uuids[index], uuidLen) == 0)
+                && (line[2 + uuidLen] == ','))
+            {
+                for (digit = 3 + uuidLen; digit < (7 + uuidLen); digit++)
+                {
+                    handles[index] = (handles[index] << 4) | RN487X_AsciiToNibble(line[digit]);
+                }
+                found++;
+            }
+        }
+    }
+    while ((length != 0) && (strncmp(line, "END", 3) != 0));
+
+    RN487X_WaitForResponse(cmdResponse[RN487X_CMD_PROMPT], RN487X_RESPONSE_TIMEOUT);
+
+    return found;
+}
+
+static bool RN487X_WaitForResponse(const char *response, uint16_t timeout)
+{
+    uint8_t match = 0;
+
+    while (response[match] != '\0')
+    {
+        if (RN487X.DataReady())
+        {
+            match = RN487X_MatchMsg(response, match, RN487X.Read());
+        }
+        else if (timeout == 0)
+        {
+            return false;
+        }
+        else
+        {
+            RN487X.DelayMs(1);
+            timeout--;
+        }
+    }
+    return true;
+}
+
+static bool RN487X_ProbeCmdMode(void)
+{
+    //Remove data received at a wrong baud rate, if any
+    while (RN487X.DataReady())
+    {
+        RN487X.Read();
+    }
+
+    RN487X_SendCmd((const uint8_t *) "$$$", 3);
+
+    return RN487X_WaitForResponse(cmdResponse[RN487X_CMD_PROMPT], RN487X_RESPONSE_TIMEOUT);
+}
+
+static void RN487X_LeaveCmdMode(void)
+{
+    RN487X_SendCmd((const uint8_t *) "---\r\n", 5);
+    RN487X_WaitForResponse(cmdResponse[RN487X_END_PROMPT], RN487X_RESPONSE_TIMEOUT);
+}
+
+static uint8_t RN487X_ReadLine(char *line, uint8_t size)
+{
+    uint8_t index = 0;
+    uint8_t readChar;
+
+    do
+    {
+        if (RN487X.ReadTimeout(&readChar, RN487X_RESPONSE_TIMEOUT) == false)
+        {
+            return 0;
+        }
+        if (index < (size - 1))
+        {
+            line[index++] = (char) readChar;
+        }
+    }
+    while (readChar != '\n');
+    line[index] = '\0';
+
+    return index;
+}
+
+bool RN487X_SetAsyncMessageHandler(char* pBuffer, uint8_t len)
+{
+    if ((pBuffer != NULL) && (len > 1))
+    {
+      asyncBuffer = pBuffer;
+      asyncBufferSize = len - 1;
+      return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool RN487X_DataReady(void)
+{
+    // the receive path also fails a command left unanswered
+    RN487X_CheckCmdTimeout();
+    if (dataReady)
+    {
+        return true;
+    }
+    
+    if (RN487X.DataReady())
+    {
+        return RN487X_FilterData();
+    }
+    return false;
+}
+
+uint8_t RN487X_Read(void)
+{
+    // unbounded by design, callers check RN487X_DataReady() first
+    while(RN487X_DataReady() == false); // Wait
+    dataReady = false;
+    return peek;
+}
+
+static bool RN487X_FilterData(void)
+{
+    uint8_t readChar = RN487X.Read();
+    
+    if(asyncBuffering == true)
+    {
+        if (RN487X_BufferStatus(readChar))
+        {
+            RN487X.AsyncHandler(statusType, asyncBuffer);
+        }
+    }
+    else
+    {
+        if (readChar == STATUS_MESSAGE_DELIMITER)
+        {
+            RN487X_StartStatus();
+        }
+        else if (cmdActive)
+        {
+            RN487X_MatchResponse(readChar);
+        }
+        else 
+        {
+            dataReady = true;
+            peek = readChar;
+        }
+    }
+    return dataReady;
+}
+
+void RN487X_SetBridgeMode(bool enable)
+{
+    bool state = INTCONbits.GIE;
+
+    if (enable == bridgeMode)
+    {
+        return;
+    }
+
+    INTERRUPT_GlobalInterruptDisable();
+    bridgeMode = enable;
+    if (enable)
+    {
+        uart[UART_BLE].SetRxISR(RN487X_BridgeBleRxISR);
+        uart[UART_BLE].SetTxISR(RN487X_BridgeBleTxISR);
+        uart[UART_CDC].SetRxISR(RN487X_BridgeCdcRxISR);
+        uart[UART_CDC].SetTxISR(RN487X_BridgeCdcTxISR);
+        // forward what was received before
+        if (dataReady)
+        {
+            dataReady = false;
+            uart[UART_CDC].TryWriteBlock(&peek, 1);
+        }
+        RN487X_BridgeToCdc();
+        RN487X_BridgeToBle();
+    }
+    else
+    {
+        uart[UART_BLE].SetRxISR(uart[UART_BLE].RxDefaultISR);
+        uart[UART_BLE].SetTxISR(uart[UART_BLE].TxDefaultISR);
+        uart[UART_CDC].SetRxISR(uart[UART_CDC].RxDefaultISR);
+        uart[UART_CDC].SetTxISR(uart[UART_CDC].TxDefaultISR);
+    }
+    INTCONbits.GIE = state;
+
+    RN487X_BridgeTasks();
+}
+
+void RN487X_BridgeTasks(void)
+{
+    bool state;
+
+    if (asyncPending)
+    {
+        RN487X.AsyncHandler(statusType, asyncBuffer);
+
+        state = INTCONbits.GIE;
+        INTERRUPT_GlobalInterruptDisable();
+        asyncPending = false;
+        if (bridgeMode)
+        {
+            // resume the data held behind the status message
+            RN487X_BridgeToCdc();
+        }
+        INTCONbits.GIE = state;
+    }
+}
+
+static void RN487X_BridgeToCdc(void)
+{
+    uint8_t readChar;
+
+    while ((asyncPending == false) && RN487X.DataReady() && uart[UART_CDC].TxSpace())
+    {
+        readChar = RN487X.Read();
+        if (asyncBuffering == true)
+        {
+            // the handler prints to the CDC UART, it runs from RN487X_BridgeTasks()
+            asyncPending = RN487X_BufferStatus(readChar);
+        }
+        else if (readChar == STATUS_MESSAGE_DELIMITER)
+        {
+            RN487X_StartStatus();
+        }
+        else
+        {
+            uart[UART_CDC].TryWriteBlock(&readChar, 1);
+        }
+    }
+}
+
+static void RN487X_BridgeToBle(void)
+{
+    uint8_t readChar;
+
+    while (uart[UART_CDC].DataReady() && RN487X.TxSpace())
+    {
+        readChar = uart[UART_CDC].Read();
+        RN487X.TryWriteBlock(&readChar, 1);
+    }
+}
+
+static void RN487X_BridgeBleRxISR(void)
+{
+    uart[UART_BLE].RxDefaultISR();
+    RN487X_BridgeToCdc();
+}
+
+static void RN487X_BridgeBleTxISR(void)
+{
+    uart[UART_BLE].TxDefaultISR();
+    RN487X_BridgeToBle();
+}
+
+static void RN487X_BridgeCdcRxISR(void)
+{
+    uart[UART_CDC].RxDefaultISR();
+    RN487X_BridgeToBle();
+}
+
+static void RN487X_BridgeCdcTxISR(void)
+{
+    uart[UART_CDC].TxDefaultISR();
+    RN487X_BridgeToCdc();
+}
+
+static void RN487X_StartStatus(void)
+{
+    asyncBuffering = true;
+    pHead = asyncBuffer;
+    statusFirst = 0;
+    statusLast = RN487X_STATUS_UNKNOWN;
+    statusIndex = 0;
+}
+
+static bool RN487X_BufferStatus(uint8_t readChar)
+{
+    if (readChar == STATUS_MESSAGE_DELIMITER)
+    {
+        asyncBuffering = false;
+        *pHead = '\0';
+        RN487X_EndStatusKeyword();
+        if (statusType == RN487X_STATUS_REBOOT)
+        {
+            rebootReceived = true;
+        }
+        return true;
+    }
+
+    if (pHead < asyncBuffer + asyncBufferSize)
+    {
+        *pHead++ = readChar;
+    }
+
+    if (statusIndex == STATUS_KEYWORD_DONE)
+    {
+        // keyword already classified, the parameters follow
+    }
+    else if ((readChar == ',') || (readChar == ':'))
+    {
+        RN487X_EndStatusKeyword();
+    }
+    else
+    {
+        // keywords sharing the matched prefix are contiguous and sorted on the next character
+        while ((statusFirst < statusLast) && ((uint8_t) statusKeyword[statusFirst][statusIndex] < readChar))
+        {
+            statusFirst++;
+        }
+        while ((statusFirst < statusLast) && ((uint8_t) statusKeyword[statusLast - 1][statusIndex] > readChar))
+        {
+            statusLast--;
+        }
+        if (statusFirst == statusLast)
+        {
+            statusType = RN487X_STATUS_UNKNOWN;
+            statusIndex = STATUS_KEYWORD_DONE;
+        }
+        else
+        {
+            statusIndex++;
+        }
+    }
+    return false;
+}
+
+static void RN487X_EndStatusKeyword(void)
+{
+    if (statusIndex == STATUS_KEYWORD_DONE)
+    {
+        return;
+    }
+    // the shortest matching keyword sorts first; it must end where the message keyword ends
+    if ((statusFirst < statusLast) && (statusKeyword[statusFirst][statusIndex] == '\0'))
+    {
+        statusType = (RN487X_STATUS_t) statusFirst;
+    }
+    else
+    {
+        statusType = RN487X_STATUS_UNKNOWN;
+    }
+    statusIndex = STATUS_KEYWORD_DONE;
+}
+
+bool RN487X_QueueCmd(const uint8_t *cmd, uint8_t cmdLen, rn487x_cmd_response_t response, rn487x_cmd_callback_t complete)
+{
+    return RN487X_EnqueueCmd(cmd, cmdLen, NULL, 0, response, complete);
+}
+
+static bool RN487X_EnqueueCmd(const uint8_t *cmd, uint8_t cmdLen, const uint8_t *value, uint8_t valueLen, rn487x_cmd_response_t response, rn487x_cmd_callback_t complete)
+{
+    rn487x_queued_cmd_t *entry;
+
+    if (((uint16_t) cmdLen + valueLen > RN487X_CMD_MAX_SIZE) || ((uint8_t)(cmdHead - cmdTail) == RN487X_CMD_QUEUE_SIZE))
+    {
+        return false;
+    }
+
+    entry = &cmdQueue[cmdHead & RN487X_CMD_QUEUE_MASK];
+    memcpy(entry->cmd, cmd, cmdLen);
+    if (valueLen)
+    {
+        memcpy(&entry->cmd[cmdLen], value, valueLen);
+    }
+    entry->cmdLen = cmdLen;
+    entry->valueLen = valueLen;
+    entry->response = response;
+    entry->complete = complete;
+    cmdHead++;
+
+    RN487X_StartNextCmd();
+    return true;
+}
+
+bool RN487X_IsCmdPending(void)
+{
+    RN487X_CheckCmdTimeout();
+    return (cmdHead != cmdTail);
+}
+
+bool RN487X_SetOutputsAsync(rn487x_gpio_bitmap_t bitMap, rn487x_cmd_callback_t complete)
+{
+    uint8_t outputsCmd[RN487X_CMD_MAX_SIZE];
+
+    return RN487X_QueueInCmdMode(outputsCmd, RN487X_FormatOutputsCmd(outputsCmd, bitMap), NULL, 0, complete);
+}
+
+bool RN487X_SetConnParamsAsync(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout, rn487x_cmd_callback_t complete)
+{
+    const uint16_t param[RN487X_CONN_PARAM_COUNT] = {minInterval, maxInterval, latency, timeout};
+    uint8_t connParamsCmd[RN487X_CMD_MAX_SIZE];
+
+    return RN487X_QueueInCmdMode(connParamsCmd, RN487X_FormatConnParamsCmd(connParamsCmd, param), NULL, 0, complete);
+}
+
+void RN487X_SetCmdModeHeld(bool hold)
+{
+    cmdModeHeld = hold;
+}
+
+bool RN487X_WriteCharacteristicAsync(uint16_t handle, const uint8_t *value, uint8_t length, rn487x_cmd_callback_t complete)
+{
+    uint8_t writeCmd[] = {'S', 'H', 'W', ',', '0', '0', '0', '0', ','};
+
+    if ((length == 0) || (length > RN487X_CHAR_VALUE_MAX_SIZE))
+    {
+        return false;
+    }
+    writeCmd[4] = NIBBLE2ASCII((handle >> 12) & 0x0F);
+    writeCmd[5] = NIBBLE2ASCII((handle >> 8) & 0x0F);
+    writeCmd[6] = NIBBLE2ASCII((handle >> 4) & 0x0F);
+    writeCmd[7] = NIBBLE2ASCII(handle & 0x0F);
+
+    // the value is queued raw and sent as hex, see RN487X_StartNextCmd()
+    return RN487X_QueueInCmdMode(writeCmd, sizeof (writeCmd), value, length, complete);
+}
+
+static bool RN487X_QueueInCmdMode(const uint8_t *cmd, uint8_t cmdLen, const uint8_t *value, uint8_t valueLen, rn487x_cmd_callback_t complete)
+{
+    const uint8_t enterCmd[] = {'$', '$', '$'};
+    const uint8_t exitCmd[] = {'-', '-', '-', '\r', '\n'};
+
+    if (((uint16_t) cmdLen + valueLen > RN487X_CMD_MAX_SIZE)
+        || ((uint8_t)(RN487X_CMD_QUEUE_SIZE - (uint8_t)(cmdHead - cmdTail)) < (cmdModeHeld ? 1 : 3)))
+    {
+        return false;
+    }
+
+    if (cmdModeHeld == false)
+    {
+        RN487X_EnqueueCmd(enterCmd, sizeof (enterCmd), NULL, 0, RN487X_CMD_PROMPT, NULL);
+    }
+    RN487X_EnqueueCmd(cmd, cmdLen, value, valueLen, RN487X_CMD_PROMPT, complete);
+    if (cmdModeHeld == false)
+    {
+        RN487X_EnqueueCmd(exitCmd, sizeof (exitCmd), NULL, 0, RN487X_END_PROMPT, NULL);
+    }
+    return true;
+}
+
+static void RN487X_StartNextCmd(void)
+{
+    rn487x_queued_cmd_t *entry;
+    uint8_t index;
+
+    if (cmdActive || (cmdHead == cmdTail))
+    {
+        return;
+    }
+
+    entry = &cmdQueue[cmdTail & RN487X_CMD_QUEUE_MASK];
+    cmdActive = true;
+    cmdMatch = 0;
+    cmdErrorMatch = 0;
+    cmdStatus = true;
+    RN487X.WriteBlock(entry->cmd, entry->cmdLen);
+    if (entry->valueLen)
+    {
+        for (index = entry->cmdLen; index < (entry->cmdLen + entry->valueLen); index++)
+        {
+            RN487X.Write(NIBBLE2ASCII(entry->cmd[index] >> 4));
+            RN487X.Write(NIBBLE2ASCII(entry->cmd[index] & 0x0F));
+        }
+        RN487X.Write('\r');
+        RN487X.Write('\n');
+    }
+    cmdStamp = TMR0_ReadTimestamp();
+}
+
+static void RN487X_CheckCmdTimeout(void)
+{
+    rn487x_queued_cmd_t *entry;
+    rn487x_cmd_response_t response;
+    rn487x_cmd_callback_t complete;
+
+    if ((cmdActive == false) || ((uint16_t)(TMR0_ReadTimestamp() - cmdStamp) < RN487X_CMD_TIMEOUT_TICKS))
+    {
+        return;
+    }
+
+    // a response byte was lost, or RN487X was reset. The failed command and the rest of
+    // its $$$ ... --- sequence are dropped, but the --- is still sent: RN487X may be left
+    // in command mode otherwise, taking all transparent UART data as commands.
+    // cmdActive stays set so a callback queueing commands does not start one meanwhile.
+    do
+    {
+        entry = &cmdQueue[cmdTail & RN487X_CMD_QUEUE_MASK];
+        response = entry->response;
+        complete = entry->complete;
+        cmdTail++;
+        if (complete)
+        {
+            complete(false);
+        }
+    }
+    while ((cmdModeHeld == false) && (response != RN487X_END_PROMPT) && (cmdHead != cmdTail)
+        && (cmdQueue[cmdTail & RN487X_CMD_QUEUE_MASK].response != RN487X_END_PROMPT));
+
+    cmdActive = false;
+    RN487X_StartNextCmd();
+}
+
+static void RN487X_MatchResponse(uint8_t readChar)
+{
+    rn487x_queued_cmd_t *entry = &cmdQueue[cmdTail & RN487X_CMD_QUEUE_MASK];
+    const char *response = cmdResponse[entry->response];
+
+    cmdErrorMatch = RN487X_MatchMsg(cmdError, cmdErrorMatch, readChar);
+    if (cmdError[cmdErrorMatch] == '\0')
+    {
+        cmdStatus = false;
+        cmdErrorMatch = 0;
+    }
+
+    cmdMatch = RN487X_MatchMsg(response, cmdMatch, readChar);
+    if (response[cmdMatch] == '\0')
+    {
+        // response complete, release the entry before the callback may queue more
+        cmdActive = false;
+        cmdTail++;
+        if (entry->complete)
+        {
+            entry->complete(cmdStatus);
+        }
+        RN487X_StartNextCmd();
+    }
+}
+
+static uint8_t RN487X_MatchMsg(const char *msg, uint8_t index, uint8_t readChar)
+{
+    if (readChar == msg[index])
+    {
+        return index + 1;
+    }
+    return (readChar == msg[0]) ? 1 : 0;
 }
@@ -29,6 +29,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "rn487x.h"   
+#include "rn487x_interface.h"
 
 /**
  * \ingroup RN487X
@@ -38,12 +39,72 @@
 
 /**
  * \ingroup RN487X
- * \brief This macro defines the RN487X boot time.
+ * \brief This macro defines the longest RN487X boot time, waiting for its %REBOOT% banner.
  */
 #define RN487X_STARTUP_DELAY            (200)
 
+/**
+ * \ingroup RN487X
+ * \brief This macro defines how long, in ms, a command response is awaited during baud rate negotiation.
+ */
+#define RN487X_RESPONSE_TIMEOUT         (100)
+
+/**
+ * \ingroup RN487X
+ * \brief This macro defines the number of commands held by the asynchronous command queue.
+ */
+#define RN487X_CMD_QUEUE_SIZE           (4)
+
+/**
+ * \ingroup RN487X
+ * \brief This macro defines the longest characteristic value written by RN487X_WriteCharacteristicAsync().
+ */
+#define RN487X_CHAR_VALUE_MAX_SIZE      (20)
+
+/**
+ * \ingroup RN487X
+ * \brief This macro defines the longest command accepted by the asynchronous command queue.
+ * Sized for the "SHW,<handle>," prefix and a raw RN487X_CHAR_VALUE_MAX_SIZE value, which
+ * also holds the T command, "T,<min>,<max>,<latency>,<timeout>\r\n".
+ */
+#define RN487X_CMD_MAX_SIZE             (9 + RN487X_CHAR_VALUE_MAX_SIZE)
+
+/**
+ * \ingroup RN487X
+ * \brief This macro defines the number of parameters of the T command.
+ */
+#define RN487X_CONN_PARAM_COUNT         (4)
+
+/**
+ * \ingroup RN487X
+ * \brief This macro defines the UART flow control bit of the SR features bitmap.
+ */
+#define RN487X_FEATURE_FLOW_CONTROL     (0x8000)
+
+/**
+ * \ingroup RN487X
+ * \brief This macro defines the Device Information bit of the SS services bitmap.
+ */
+#define RN487X_SERVICE_DEVICE_INFO      (0x80)
+
+/**
+ * \ingroup RN487X
+ * \brief This macro defines the Transparent UART bit of the SS services bitmap.
+ */
+#define RN487X_SERVICE_TRANSPARENT_UART (0x40)
+
+/**
+ * \ingroup RN487X
+ * \brief These macros define the PC characteristic property bits.
+ */
+#define RN487X_PROPERTY_READ            (0x02)
+#define RN487X_PROPERTY_WRITE_NO_RSP    (0x04)
+#define RN487X_PROPERTY_WRITE           (0x08)
+#define RN487X_PROPERTY_NOTIFY          (0x10)
+#define RN487X_PROPERTY_INDICATE        (0x20)
+
 //Convert nibble to ASCII
-#define NIBBLE2ASCII(nibble) (((nibble < 0x0A) ? (nibble + '0') : (nibble + 0x57)))
+#define NIBBLE2ASCII(nibble) ((((nibble) < 0x0A) ? ((nibble) + '0') : ((nibble) + 0x57)))
 
 /**
  * \ingroup RN487X
@@ -98,18 +159,53 @@ typedef union
     };
 }rn487x_gpio_bitmap_t;
 
+/**
+ * \ingroup RN487X
+ * Enumeration of the response ending a queued command
+ */
+typedef enum
+{
+    RN487X_CMD_PROMPT,          // "CMD> ", after $$$ and after the AOK/Err of a command
+    RN487X_END_PROMPT           // "END\r\n", after ---
+}rn487x_cmd_response_t;
+
+/**
+ * \ingroup RN487X
+ * Completion callback of a queued command
+ * status is false when the RN487X answered Err
+ */
+typedef void (*rn487x_cmd_callback_t)(bool status);
+
  /**
   * \ingroup RN487X
   * \brief Initializes RN487X Device
   * 
-  * This API initializes RN487X Device.
+  * This API resets RN487X Device and returns once its %REBOOT% banner has been
+  * received, waiting at most RN487X_STARTUP_DELAY. The banner is handled by
+  * the status message handler, so RN487X_SetAsyncMessageHandler() is called
+  * first.
   * 
   * \return Initialization Status.
-  * \retval true - Success
-  * \retval false - Failure.
+  * \retval true - Success, RN487X reported its reboot
+  * \retval false - Failure, no banner before the timeout.
   */
 bool RN487X_Init(void);
 
+ /**
+  * \ingroup RN487X
+  * \brief Waits for the %REBOOT% banner of RN487X.
+  * 
+  * The data received meanwhile goes through the status message handling and
+  * is otherwise dropped. Used after a reset or a reboot command, in place of a
+  * fixed boot delay.
+  * 
+  * \param timeout Longest wait, in ms
+  * \return Reboot Status
+  * \retval true - Banner received
+  * \retval false - No banner before the timeout, or no status message buffer set
+  */
+bool RN487X_WaitForReboot(uint16_t timeout);
+
  /**
   * \ingroup RN487X
   * \brief Sends out command to RN487X.
@@ -129,6 +225,8 @@ void RN487X_SendCmd(const uint8_t *cmd, uint8_t cmdLen);
  * 
  * This API gets the config value from RN487X by sending get command.
  * For more details, refer section 2.5 GET COMMANDS in RN4870-71 user guide.
+ * The response is read up to '\n', or until no byte is received for
+ * RN487X_RESPONSE_TIMEOUT.
  * 
  * \param getCmd Get command to send
  * \param getCmdLen Get command length
@@ -145,7 +243,7 @@ uint8_t RN487X_GetCmd(const char *getCmd, uint8_t getCmdLen, char *getCmdResp);
   * 
   * This API takes input from application on the expected response/status 
   * message. It starts read RN487X host interface immediately and look for 
-  * expected message.
+  * expected message. Each byte is waited for at most RN487X_RESPONSE_TIMEOUT.
   * 
   * \param expectedMsg Expected response/status message from RN487X
   * \param msgLen Expected response/status message length.
@@ -160,6 +258,7 @@ bool RN487X_ReadMsg(const uint8_t *expectedMsg, uint8_t msgLen);
   * \brief Reads default response from RN487X.
   * 
   * This API reads RN487X interface for default response which is AOK or ERR.
+  * Each byte is waited for at most RN487X_RESPONSE_TIMEOUT.
   * 
   * \return Response Status
   * \retval true - Default Response Received
@@ -256,6 +355,109 @@ bool RN487X_RebootCmd(void);
   */
 bool RN487X_Disconnect(void);
 
+ /**
+  * \ingroup RN487X
+  * \brief Configures UART hardware flow control of RN487X.
+  * 
+  * This API reads the features bitmap (GR command) and, when the flow control
+  * bit differs, writes it back (SR command) and reboots RN487X so the setting
+  * takes effect. For more details, refer GR, SR and R commands in RN4870-71
+  * user guide.
+  * \param enable true to enable RTS/CTS flow control, false to disable it
+  * \return Configuration Status
+  * \retval true - RN487X uses the requested flow control setting
+  * \retval false - Failure
+  */
+bool RN487X_SetFlowControl(bool enable);
+
+ /**
+  * \ingroup RN487X
+  * \brief Moves the RN487X UART to a higher baud rate.
+  * 
+  * This API checks whether RN487X already answers at the target baud rate.
+  * Otherwise it sets the target rate at the current one (SB command), reboots
+  * RN487X and verifies it answers at the target rate. The SB setting is saved
+  * by RN487X, so when it answers at neither rate every other rate is probed,
+  * and the module found is set back to the current rate. The UART follows
+  * every change.
+  * For more details, refer SB and R commands in RN4870-71 user guide.
+  * \param target Baud rate to move to
+  * \param current Baud rate RN487X and the UART use at boot
+  * \return Negotiation Status
+  * \retval true - RN487X answers at the rate the UART uses on return
+  * \retval false - RN487X answers at no baud rate, or the UART transmitter
+  *                 stalled and the UART rate could not be changed
+  */
+bool RN487X_NegotiateBaudRate(RN487X_BAUD_RATES_t target, RN487X_BAUD_RATES_t current);
+
+ /**
+  * \ingroup RN487X
+  * \brief Selects the services RN487X offers.
+  * 
+  * This API must be called from command mode; the setting takes effect after
+  * a reboot. For more details, refer SS command in RN4870-71 user guide.
+  * \param services RN487X_SERVICE_DEVICE_INFO | RN487X_SERVICE_TRANSPARENT_UART
+  * \return Set Services Status
+  * \retval true - Success
+  * \retval false - Failure
+  */
+bool RN487X_SetServiceBitmap(uint8_t services);
+
+ /**
+  * \ingroup RN487X
+  * \brief Removes every private service and characteristic.
+  * 
+  * This API must be called from command mode; the change takes effect after
+  * a reboot. For more details, refer PZ command in RN4870-71 user guide.
+  * \return Clear Status
+  * \retval true - Success
+  * \retval false - Failure
+  */
+bool RN487X_ClearPrivateServices(void);
+
+ /**
+  * \ingroup RN487X
+  * \brief Starts the definition of a private service.
+  * 
+  * The characteristics defined next with RN487X_SetPrivateCharacteristic()
+  * belong to this service. This API must be called from command mode; the
+  * service is stored by RN487X and offered after a reboot.
+  * For more details, refer PS command in RN4870-71 user guide.
+  * \param uuid Service UUID, (32) hex characters
+  * \return Define Service Status
+  * \retval true - Success
+  * \retval false - Failure
+  */
+bool RN487X_SetPrivateService(const char *uuid);
+
+ /**
+  * \ingroup RN487X
+  * \brief Adds a characteristic to the private service being defined.
+  * 
+  * This API must be called from command mode.
+  * For more details, refer PC command in RN4870-71 user guide.
+  * \param uuid Characteristic UUID, (32) hex characters
+  * \param properties RN487X_PROPERTY_x bits
+  * \param size Value size, up to RN487X_CHAR_VALUE_MAX_SIZE
+  * \return Define Characteristic Status
+  * \retval true - Success
+  * \retval false - Failure
+  */
+bool RN487X_SetPrivateCharacteristic(const char *uuid, uint8_t properties, uint8_t size);
+
+ /**
+  * \ingroup RN487X
+  * \brief Looks up the handles of server characteristics.
+  * 
+  * This API lists the services of RN487X (LS command) and picks the value
+  * handle of every UUID found. It must be called from command mode.
+  * \param uuids Characteristic UUIDs, (32) hex characters, upper case
+  * \param handles Handle of each UUID, 0 when not found
+  * \param count Number of UUIDs
+  * \return Number of UUIDs found
+  */
+uint8_t RN487X_GetCharacteristicHandles(const char * const *uuids, uint16_t *handles, uint8_t count);
+
  /**
   * \ingroup RN487X
   * \brief Sets up the Buffer and Buffer Size for Aysnc Message Handler
@@ -287,9 +489,138 @@ bool RN487X_DataReady(void);
   * \brief Read incoming Data using Async Message Handling
   * 
   * This API reads incoming data using Async Message Handling.
-  * This API follows the standard UART form.
+  * This API follows the standard UART form: it blocks until a byte is received,
+  * with no timeout. It is left unbounded because it is only called once
+  * RN487X_DataReady() has returned true, so the wait never starts; a caller
+  * that needs a bounded wait polls RN487X_DataReady() against its own deadline.
   * \return Data Read
   */
 uint8_t RN487X_Read(void);
 
+ /**
+  * \ingroup RN487X
+  * \brief Bridges the CDC UART and the RN487X UART from the interrupts
+  * 
+  * While the bridge is on, the receive and transmit interrupts of both UARTs
+  * forward the data from one receive ring to the other transmit ring, without
+  * main loop involvement. Status messages between '%' delimiters are still
+  * filtered from the RN487X data; their Async Message Handler runs from
+  * RN487X_BridgeTasks(), which must be called from the main loop while bridging.
+  * A UART that cannot take more data holds the other one back, so the rings
+  * fill up instead of dropping data.
+  * RN487X_DataReady() returns no data, and neither UART may be written by
+  * the application, while the bridge is on. Commands must not be queued.
+  * \param enable true - Bridge the UARTs | false - Restore the default handlers
+  * \return Nothing
+  */
+void RN487X_SetBridgeMode(bool enable);
+
+ /**
+  * \ingroup RN487X
+  * \brief Handles the status messages filtered by the bridge
+  * 
+  * This API calls the Async Message Handler for a status message filtered by
+  * the interrupts in bridge mode, then resumes the data held behind it.
+  * \return Nothing
+  */
+void RN487X_BridgeTasks(void);
+
+ /**
+  * \ingroup RN487X
+  * \brief Queues a command for asynchronous execution.
+  * 
+  * This API copies the command into the command queue and returns immediately.
+  * Queued commands are sent one at a time; the response is matched
+  * incrementally from the RX stream by RN487X_DataReady(), and the next
+  * command is sent once the expected response has been received.
+  * The response bytes are not returned by RN487X_Read().
+  * 
+  * \param cmd RN487X command
+  * \param cmdLen RN487X command length, up to RN487X_CMD_MAX_SIZE
+  * \param response Response ending the command
+  * \param complete Called once the response has been received, may be NULL
+  * \return Queue Status
+  * \retval true - Command queued
+  * \retval false - Queue full or command too long
+  */
+bool RN487X_QueueCmd(const uint8_t *cmd, uint8_t cmdLen, rn487x_cmd_response_t response, rn487x_cmd_callback_t complete);
+
+ /**
+  * \ingroup RN487X
+  * \brief Checks if queued commands are still in progress.
+  * 
+  * While commands are pending the RN487X may be in command mode, so no data
+  * should be written to it. A command not answered within RN487X_RESPONSE_TIMEOUT
+  * is failed here, and by RN487X_DataReady(), together with the rest of its
+  * $$$ ... --- sequence; the closing --- is still sent to leave command mode.
+  * 
+  * \return Command Queue Status
+  * \retval true - Commands pending
+  * \retval false - Command queue empty
+  */
+bool RN487X_IsCmdPending(void);
+
+ /**
+  * \ingroup RN487X
+  * \brief Configures RN487X GPIO pins as output, and sets state, without waiting
+  * 
+  * This API queues the $$$, |O and --- commands performing RN487X_SetOutputs()
+  * from command mode, and returns immediately. Only |O is queued while command
+  * mode is held.
+  * \param bitMap RN487X GPIO Output I/O & Low/High State
+  * \param complete Called with the |O status, may be NULL
+  * \return Queue Status
+  * \retval true - Commands queued
+  * \retval false - Not enough room in the command queue
+  */
+bool RN487X_SetOutputsAsync(rn487x_gpio_bitmap_t bitMap, rn487x_cmd_callback_t complete);
+
+ /**
+  * \ingroup RN487X
+  * \brief Requests new connection parameters from the peer, without waiting
+  * 
+  * This API queues the $$$, T and --- commands, only T while command mode is
+  * held, and returns immediately. It is
+  * only valid while connected. The central decides; the parameters it accepts
+  * are reported by the %CONN_PARAM% status message (RN487X_EVENT_CONN_PARAM),
+  * and a refusal by %ERR_CONNPARAM% (RN487X_EVENT_CONN_PARAM_REJECTED).
+  * \param minInterval Minimum connection interval, in 1.25 ms units (0x0006 - 0x0C80)
+  * \param maxInterval Maximum connection interval, in 1.25 ms units (0x0006 - 0x0C80)
+  * \param latency Slave latency, in connection events (0x0000 - 0x01F3)
+  * \param timeout Supervision timeout, in 10 ms units (0x000A - 0x0C80)
+  * \param complete Called with the T status, may be NULL
+  * \return Queue Status
+  * \retval true - Commands queued
+  * \retval false - Not enough room in the command queue
+  */
+bool RN487X_SetConnParamsAsync(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout, rn487x_cmd_callback_t complete);
+
+ /**
+  * \ingroup RN487X
+  * \brief Keeps RN487X in command mode between asynchronous commands.
+  * 
+  * While held, the asynchronous APIs queue their command alone instead of
+  * wrapping it in $$$ and ---. The caller enters command mode before holding
+  * it, and leaves it after releasing it.
+  * \param hold true - RN487X stays in command mode | false - command mode is entered per command
+  */
+void RN487X_SetCmdModeHeld(bool hold);
+
+ /**
+  * \ingroup RN487X
+  * \brief Writes a server characteristic value, without waiting
+  * 
+  * This API queues the SHW command, between $$$ and --- unless command mode is
+  * held, and returns immediately. The value is copied; a subscribed client is
+  * notified of it. For more details, refer SHW command in RN4870-71 user guide.
+  * \param handle Characteristic handle, see RN487X_GetCharacteristicHandles()
+  * \param value Value bytes
+  * \param length Value length, 1 to RN487X_CHAR_VALUE_MAX_SIZE
+  * \param complete Called with the SHW status, may be NULL
+  * \return Queue Status
+  * \retval true - Commands queued
+  * \retval false - Not enough room in the command queue, or invalid length
+  */
+bool RN487X_WriteCharacteristicAsync(uint16_t handle, const uint8_t *value, uint8_t length, rn487x_cmd_callback_t complete);
+
 #endif	/* RN487X_H */
\ No newline at end of file
@@ -29,8 +29,17 @@
 #include "rn487x_interface.h"
 #include "../mcc.h"
 #include "../drivers/uart.h"
+#include "../config/BLE_Explorer_config.h"
 
 static bool connected = false; //**< RN487X connection state */
+static rn487x_event_handler_t eventHandler[RN487X_EVENT_SUBSCRIBERS_MAX];      /**< Subscribed RN487X Event handlers */
+static uint8_t eventHandlerCount = 0;                                           /**< Number of subscribed RN487X Event handlers */
+static const uint16_t baudDivisor[] = {                        /**< UART_BLE baud rate generator value, indexed by RN487X_BAUD_RATES_t */
+    EUSART2_BAUD_DIVISOR(921600UL), EUSART2_BAUD_DIVISOR(460800UL), EUSART2_BAUD_DIVISOR(230400UL),
+    EUSART2_BAUD_DIVISOR(115200UL), EUSART2_BAUD_DIVISOR(57600UL), EUSART2_BAUD_DIVISOR(38400UL),
+    EUSART2_BAUD_DIVISOR(28800UL), EUSART2_BAUD_DIVISOR(19200UL), EUSART2_BAUD_DIVISOR(14400UL),
+    EUSART2_BAUD_DIVISOR(9600UL)
+};
 
 /**
  * \ingroup RN487X_INTERFACE
@@ -74,12 +83,35 @@ static void RN487X_SetSystemMode(RN487X_SYSTEM_MODES_t mode);
  * 
  * This API is used to handle incoming status messages.
  * It prints all status messages, If DISCONNECT or STREAM_OPEN is received it manages
- * the state of bool connected.
+ * the state of bool connected. The subscribed handlers are then notified of the event.
+ * 
+ * \param status Status message, classified while it was received
+ * \param message Passed status message
+ * \return Nothing
+ */
+static void RN487X_MessageHandler(RN487X_STATUS_t status, char* message);
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * \brief Builds the RN487X Event of a status message and calls the subscribed handlers
  * 
+ * \param status Status message classification
  * \param message Passed status message
  * \return Nothing
  */
-static void RN487X_MessageHandler(char* message);
+static void RN487X_NotifyEvent(RN487X_STATUS_t status, char* message);
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * \brief Parses the next ',' separated hex field of a status message
+ * 
+ * \param field Position in the message, moved past the field
+ * \param value Field value
+ * \return Parse Status
+ * \retval true - Field parsed.
+ * \retval false - No more fields
+ */
+static bool RN487X_ParseHexField(const char **field, uint16_t *value);
 
 /**
  * \ingroup RN487X_INTERFACE
@@ -113,6 +145,126 @@ static inline void RN487X_Write(uint8_t txData);
  */
 static inline uint8_t RN487X_Read(void);
 
+/**
+ * \ingroup RN487X_INTERFACE
+ * \brief Timed Read API to capture a data byte from RN487X module
+ * 
+ * This API is used to receive a data byte from the RN487X module, giving up
+ * when the module does not send it in time
+ *
+ * HINT: This API is in place to give compile time memory allocation.
+ *       Functionality exist locally within file.
+ *       Use of IN LINE to prevent additional stack depth requirement. 
+ *       APIs can be injected in place if suitable to save (1) stack depth level
+ * 
+ * \param rxData - location receiving the data byte
+ * \param timeout - time to wait for the data byte, in ms
+ * \return bool status - true: byte captured | false: timeout
+ */
+static inline bool RN487X_ReadTimeout(uint8_t *rxData, uint16_t timeout);
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * \brief Block Write API transmitting to RN487X module
+ * 
+ * This API is used to send a buffer of data bytes to the RN487X module
+ *
+ * HINT: This API is in place to give compile time memory allocation.
+ *       Functionality exist locally within file.
+ *       Use of IN LINE to prevent additional stack depth requirement. 
+ *       APIs can be injected in place if suitable to save (1) stack depth level
+ * 
+ * \param txData - data bytes to send
+ * \param length - number of bytes to send
+ * \return Nothing
+ */
+static inline void RN487X_WriteBlock(const uint8_t *txData, uint8_t length);
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * \brief Block Read API to capture data bytes from RN487X module
+ * 
+ * This API is used to receive the data bytes already buffered from the RN487X module
+ *
+ * HINT: This API is in place to give compile time memory allocation.
+ *       Functionality exist locally within file.
+ *       Use of IN LINE to prevent additional stack depth requirement. 
+ *       APIs can be injected in place if suitable to save (1) stack depth level
+ * 
+ * \param rxData - buffer receiving the data bytes
+ * \param maxLength - size of the buffer
+ * \return uint8_t count - Number of bytes captured from RN487X module
+ */
+static inline uint8_t RN487X_ReadBlock(uint8_t *rxData, uint8_t maxLength);
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * \brief Non-blocking Block Write API transmitting to RN487X module
+ * 
+ * This API is used to send as many data bytes to the RN487X module as the
+ * transmit buffer can take without waiting
+ *
+ * HINT: This API is in place to give compile time memory allocation.
+ *       Functionality exist locally within file.
+ *       Use of IN LINE to prevent additional stack depth requirement. 
+ *       APIs can be injected in place if suitable to save (1) stack depth level
+ * 
+ * \param txData - data bytes to send
+ * \param length - number of bytes to send
+ * \return uint8_t count - Number of bytes accepted for the RN487X module
+ */
+static inline uint8_t RN487X_TryWriteBlock(const uint8_t *txData, uint8_t length);
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * \brief Returns the free transmit buffer space towards RN487X module
+ * 
+ * This API is used to check how many bytes can be sent without waiting
+ *
+ * HINT: This API is in place to give compile time memory allocation.
+ *       Functionality exist locally within file.
+ *       Use of IN LINE to prevent additional stack depth requirement. 
+ *       APIs can be injected in place if suitable to save (1) stack depth level
+ * 
+ * \param N/A
+ * \return uint8_t space - Number of free bytes in the transmit buffer
+ */
+static inline uint8_t RN487X_TxSpace(void);
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * \brief Sets the handler called once all data to RN487X module was handed to the UART
+ * 
+ * This API is used to be notified when the transmit buffer has drained
+ *
+ * HINT: This API is in place to give compile time memory allocation.
+ *       Functionality exist locally within file.
+ *       Use of IN LINE to prevent additional stack depth requirement. 
+ *       APIs can be injected in place if suitable to save (1) stack depth level
+ * 
+ * \param handler - function called from the transmit interrupt
+ * \return Nothing
+ */
+static inline void RN487X_SetTxDrainedHandler(void (*handler)(void));
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * \brief Changes the baud rate of the UART connected to RN487X module
+ * 
+ * This API is used to follow a baud rate change of the RN487X module
+ *
+ * HINT: This API is in place to give compile time memory allocation.
+ *       Functionality exist locally within file.
+ *       Use of IN LINE to prevent additional stack depth requirement. 
+ *       APIs can be injected in place if suitable to save (1) stack depth level
+ * 
+ * \param baudRate - new baud rate
+ * \return Change Status
+ * \retval true - UART runs at the new baud rate
+ * \retval false - Transmitter did not drain, baud rate unchanged
+ */
+static inline bool RN487X_SetBaudRate(RN487X_BAUD_RATES_t baudRate);
+
 /**
  * \ingroup RN487X_INTERFACE
  * \brief Returns if Write to RN487X module was completed
@@ -164,21 +316,6 @@ static inline void RN487X_Delay(uint16_t delayCount);
 /*****************************************************
 *   *OPTIONAL* APPLICATION MESSAGE FORMATTING API(s)
 ******************************************************/  
-/**
- * \ingroup RN487X_MESSAGE_TYPE
- * Enum of the MESSAGE TYPES supported in Driver Example(s)
- */
-typedef enum 
-{
-    DISCONNECT_MSG  = 0,
-    STREAM_OPEN_MSG = 1,
-    GENERAL_MSG     = 2,
-}RN487X_MESSAGE_TYPE;
-/**
- * \def GENERAL_PRINT_SIZE_LIMIT
- * This macro provide a definition used to process 
- */
-#define GENERAL_PRINT_SIZE_LIMIT        (32)
 /**
  * \ingroup RN487X_MESSAGE
  * \brief Prints the START Message "<<< " for UART_CDC
@@ -209,7 +346,7 @@ static inline void rn487x_PrintMessageEnd(void);
  * \param N/A
  * \return N/A
  */
-static inline void rn487x_PrintIndicatorCharacters(RN487X_MESSAGE_TYPE messageType);
+static inline void rn487x_PrintIndicatorCharacters(RN487X_STATUS_t status);
 /**
  * \ingroup RN487X_MESSAGE
  * 
@@ -227,8 +364,15 @@ static inline void rn487x_PrintMessage(char* passedMessage);
 const iRN487X_FunctionPtrs_t RN487X = {
     .Write = RN487X_Write,
     .Read = RN487X_Read,
+    .ReadTimeout = RN487X_ReadTimeout,
     .TransmitDone = RN487X_is_tx_done,
     .DataReady = RN487X_is_rx_ready,
+    .WriteBlock = RN487X_WriteBlock,
+    .ReadBlock = RN487X_ReadBlock,
+    .TryWriteBlock = RN487X_TryWriteBlock,
+    .TxSpace = RN487X_TxSpace,
+    .SetTxDrainedHandler = RN487X_SetTxDrainedHandler,
+    .SetBaudRate = RN487X_SetBaudRate,
     .IndicateRx = RN487X_IndicateRx,
     .ResetModule = RN487X_Reset,
     .SetSystemMode = RN487X_SetSystemMode,
@@ -245,6 +389,29 @@ bool RN487X_IsConnected(void)
     return connected;
 }
 
+bool RN487X_SubscribeEvents(rn487x_event_handler_t handler)
+{
+    if ((handler == NULL) || (eventHandlerCount == RN487X_EVENT_SUBSCRIBERS_MAX))
+    {
+        return false;
+    }
+    eventHandler[eventHandlerCount++] = handler;
+    return true;
+}
+
+uint8_t RN487X_AsciiToNibble(uint8_t ascii)
+{
+    if (ascii >= 'a')
+    {
+        return ascii - 'a' + 0x0A;
+    }
+    if (ascii >= 'A')
+    {
+        return ascii - 'A' + 0x0A;
+    }
+    return ascii - '0';
+}
+
 /*****************************************************
 *   Driver Implementation Private API(s)
 ******************************************************/  
@@ -259,6 +426,41 @@ static inline uint8_t RN487X_Read(void)
     return uart[UART_BLE].Read();
 }
 
+static inline bool RN487X_ReadTimeout(uint8_t *rxData, uint16_t timeout)
+{
+    return uart[UART_BLE].ReadTimeout(rxData, timeout);
+}
+
+static inline void RN487X_WriteBlock(const uint8_t *txData, uint8_t length)
+{
+    uart[UART_BLE].WriteBlock(txData, length);
+}
+
+static inline uint8_t RN487X_ReadBlock(uint8_t *rxData, uint8_t maxLength)
+{
+    return uart[UART_BLE].ReadBlock(rxData, maxLength);
+}
+
+static inline uint8_t RN487X_TryWriteBlock(const uint8_t *txData, uint8_t length)
+{
+    return uart[UART_BLE].TryWriteBlock(txData, length);
+}
+
+static inline uint8_t RN487X_TxSpace(void)
+{
+    return uart[UART_BLE].TxSpace();
+}
+
+static inline void RN487X_SetTxDrainedHandler(void (*handler)(void))
+{
+    uart[UART_BLE].SetTxDrainedISR(handler);
+}
+
+static inline bool RN487X_SetBaudRate(RN487X_BAUD_RATES_t baudRate)
+{
+    return uart[UART_BLE].SetBaudDivisor(baudDivisor[baudRate]);
+}
+
 static inline bool RN487X_is_tx_done(void)
 {
     return uart[UART_BLE].TransmitDone();
@@ -322,30 +524,29 @@ static void RN487X_SetSystemMode(RN487X_SYSTEM_MODES_t mode)
 
 static inline void rn487x_PrintMessageStart(void)
 {
-    uart[UART_CDC].Write('<');
-    uart[UART_CDC].Write('<');
-    uart[UART_CDC].Write('<');
-    uart[UART_CDC].Write(' ');
+    static const uint8_t messageStart[] = {'<', '<', '<', ' '};
+
+    uart[UART_CDC].WriteBlock(messageStart, sizeof (messageStart));
 }
 
 static inline void rn487x_PrintMessageEnd(void)
 {
-    uart[UART_CDC].Write(' ');
-    uart[UART_CDC].Write('>');
-    uart[UART_CDC].Write('>');
-    uart[UART_CDC].Write('>');
-    uart[UART_CDC].Write(' ');
-    uart[UART_CDC].Write('\r');
-    uart[UART_CDC].Write('\n');
+    static const uint8_t messageEnd[] = {' ', '>', '>', '>', ' ', '\r', '\n'};
+
+    uart[UART_CDC].WriteBlock(messageEnd, sizeof (messageEnd));
 }
 
-static inline void rn487x_PrintIndicatorCharacters(RN487X_MESSAGE_TYPE messageType)
+static inline void rn487x_PrintIndicatorCharacters(RN487X_STATUS_t status)
 {
-    if (DISCONNECT_MSG == messageType)
+    if (RN487X_STATUS_DISCONNECT == status)
     {
         uart[UART_CDC].Write('[');
     }
-    else if (STREAM_OPEN_MSG == messageType)
+#if BLE_PRIVATE_SERVICE
+    else if (RN487X_STATUS_CONNECT == status)
+#else
+    else if (RN487X_STATUS_STREAM_OPEN == status)
+#endif
     {
         uart[UART_CDC].Write(']');
     }
@@ -357,33 +558,119 @@ static inline void rn487x_PrintIndicatorCharacters(RN487X_MESSAGE_TYPE messageTy
 
 static inline void rn487x_PrintMessage(char* passedMessage)
 {
-    char printCharacter [GENERAL_PRINT_SIZE_LIMIT];
-    strcpy(printCharacter, passedMessage);
-    for (uint8_t messageIndex = 0; messageIndex < strlen(passedMessage); messageIndex++)
-    {
-        uart[UART_CDC].Write(printCharacter[messageIndex]);  
-    }
+    uart[UART_CDC].WriteBlock((const uint8_t *) passedMessage, strlen(passedMessage));
 }
 
-static void RN487X_MessageHandler(char* message)
+static void RN487X_MessageHandler(RN487X_STATUS_t status, char* message)
 {
-    RN487X_MESSAGE_TYPE messageType;
     rn487x_PrintMessageStart();
-    if (strstr(message, "DISCONNECT"))
+    if (RN487X_STATUS_DISCONNECT == status)
     {
-        messageType = DISCONNECT_MSG;
         connected = false;
     }
-    else if (strstr(message, "STREAM_OPEN"))
+#if BLE_PRIVATE_SERVICE
+    // the private service is written from command mode, no stream is opened
+    else if (RN487X_STATUS_CONNECT == status)
+#else
+    else if (RN487X_STATUS_STREAM_OPEN == status)
+#endif
     {
-        messageType = STREAM_OPEN_MSG;
         connected = true;
     }
-    else
-    {
-        messageType = GENERAL_MSG;
-    }
     rn487x_PrintMessage(message);
     rn487x_PrintMessageEnd();
-    rn487x_PrintIndicatorCharacters(messageType);
+    rn487x_PrintIndicatorCharacters(status);
+    RN487X_NotifyEvent(status, message);
+}
+
+static void RN487X_NotifyEvent(RN487X_STATUS_t status, char* message)
+{
+    rn487x_event_t event;
+    const char *field = message;
+    uint16_t addressType;
+    uint8_t *value;
+    uint8_t index;
+
+    switch (status)
+    {
+        case RN487X_STATUS_CONNECT:
+            event.type = RN487X_EVENT_CONNECT;
+            if ((RN487X_ParseHexField(&field, &addressType) == false) || (*field++ != ','))
+            {
+                return;
+            }
+            event.connection.connect.addressType = (uint8_t) addressType;
+            // the address is too long for one field value, read it (2) characters at a time
+            for (index = 0; index < RN487X_ADDRESS_SIZE; index++)
+            {
+                event.connection.connect.address[index] = 0;
+                if ((field[0] != '\0') && (field[1] != '\0'))
+                {
+                    event.connection.connect.address[index] = (uint8_t) ((RN487X_AsciiToNibble(field[0]) << 4) | RN487X_AsciiToNibble(field[1]));
+                    field += 2;
+                }
+            }
+            break;
+        case RN487X_STATUS_DISCONNECT:
+            event.type = RN487X_EVENT_DISCONNECT;
+            break;
+        case RN487X_STATUS_STREAM_OPEN:
+            event.type = RN487X_EVENT_STREAM_OPEN;
+            break;
+        case RN487X_STATUS_CONN_PARAM:
+            event.type = RN487X_EVENT_CONN_PARAM;
+            if ((RN487X_ParseHexField(&field, &event.connection.param.interval) == false)
+                || (RN487X_ParseHexField(&field, &event.connection.param.latency) == false)
+                || (RN487X_ParseHexField(&field, &event.connection.param.timeout) == false))
+            {
+                return;
+            }
+            break;
+        case RN487X_STATUS_REBOOT:
+            event.type = RN487X_EVENT_REBOOT;
+            break;
+        case RN487X_STATUS_ERR_CONNPARAM:
+            event.type = RN487X_EVENT_CONN_PARAM_REJECTED;
+            break;
+        case RN487X_STATUS_WV:
+            event.type = RN487X_EVENT_CHAR_WRITE;
+            if ((RN487X_ParseHexField(&field, &event.connection.write.handle) == false) || (*field++ != ','))
+            {
+                return;
+            }
+            // the value is decoded in place, over its own hex characters
+            value = (uint8_t *) &message[field - message];
+            for (index = 0; (field[0] != '\0') && (field[1] != '\0'); index++)
+            {
+                value[index] = (uint8_t) ((RN487X_AsciiToNibble(field[0]) << 4) | RN487X_AsciiToNibble(field[1]));
+                field += 2;
+            }
+            event.connection.write.value = value;
+            event.connection.write.length = index;
+            break;
+        default:
+            return;
+    }
+
+    for (index = 0; index < eventHandlerCount; index++)
+    {
+        eventHandler[index](&event);
+    }
+}
+
+static bool RN487X_ParseHexField(const char **field, uint16_t *value)
+{
+    const char *cursor = strchr(*field, ',');
+
+    if (cursor == NULL)
+    {
+        return false;
+    }
+    *value = 0;
+    while ((*++cursor != '\0') && (*cursor != ','))
+    {
+        *value = (*value << 4) | RN487X_AsciiToNibble(*cursor);
+    }
+    *field = cursor;
+    return true;
 }
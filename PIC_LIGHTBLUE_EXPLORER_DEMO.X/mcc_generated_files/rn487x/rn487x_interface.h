@@ -40,6 +40,125 @@ typedef enum
     APPLICATION_MODE    = 0x01 
 }RN487X_SYSTEM_MODES_t;
 
+/**
+ * \ingroup RN487X_INTERFACE
+ * Enum of the RN487X UART Baud Rates, valued as the SB command argument
+ */
+typedef enum
+{
+    RN487X_BAUD_921600  = 0x00,
+    RN487X_BAUD_460800  = 0x01,
+    RN487X_BAUD_230400  = 0x02,
+    RN487X_BAUD_115200  = 0x03,
+    RN487X_BAUD_57600   = 0x04,
+    RN487X_BAUD_38400   = 0x05,
+    RN487X_BAUD_28800   = 0x06,
+    RN487X_BAUD_19200   = 0x07,
+    RN487X_BAUD_14400   = 0x08,
+    RN487X_BAUD_9600    = 0x09
+}RN487X_BAUD_RATES_t;
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * Enum of the RN487X Status Messages, classified by the keyword before the first
+ * ',' or ':' of the message. Kept in the alphabetical (ASCII) order of the keywords.
+ */
+typedef enum
+{
+    RN487X_STATUS_ADV_TIMEOUT   = 0,
+    RN487X_STATUS_BONDED        = 1,
+    RN487X_STATUS_CONNECT       = 2,
+    RN487X_STATUS_CONN_PARAM    = 3,
+    RN487X_STATUS_DISCONNECT    = 4,
+    RN487X_STATUS_ERR_CONNPARAM = 5,
+    RN487X_STATUS_ERR_MEMORY    = 6,
+    RN487X_STATUS_ERR_READ      = 7,
+    RN487X_STATUS_ERR_RMT_CMD   = 8,
+    RN487X_STATUS_ERR_SEC       = 9,
+    RN487X_STATUS_INDI          = 10,
+    RN487X_STATUS_KEY           = 11,
+    RN487X_STATUS_KEY_REQ       = 12,
+    RN487X_STATUS_NOTI          = 13,
+    RN487X_STATUS_REBOOT        = 14,
+    RN487X_STATUS_RMT_CMD_OFF   = 15,
+    RN487X_STATUS_RMT_CMD_ON    = 16,
+    RN487X_STATUS_SECURED       = 17,
+    RN487X_STATUS_STREAM_OPEN   = 18,
+    RN487X_STATUS_S_RUN         = 19,
+    RN487X_STATUS_TMR1          = 20,
+    RN487X_STATUS_TMR2          = 21,
+    RN487X_STATUS_TMR3          = 22,
+    RN487X_STATUS_WC            = 23,
+    RN487X_STATUS_WV            = 24,
+    RN487X_STATUS_UNKNOWN       = 25
+}RN487X_STATUS_t;
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * \def RN487X_EVENT_SUBSCRIBERS_MAX
+ * Maximum number of handlers subscribed through RN487X_SubscribeEvents()
+ */
+#ifndef RN487X_EVENT_SUBSCRIBERS_MAX
+#define RN487X_EVENT_SUBSCRIBERS_MAX    (2)
+#endif
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * \def RN487X_ADDRESS_SIZE
+ * Size of a Bluetooth device address, in bytes
+ */
+#define RN487X_ADDRESS_SIZE             (6)
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * Enum of the RN487X Events delivered to the subscribed handlers
+ */
+typedef enum
+{
+    RN487X_EVENT_CONNECT        = 0,    /**< %CONNECT,<type>,<address>% - connection.connect is valid */
+    RN487X_EVENT_DISCONNECT     = 1,    /**< %DISCONNECT% */
+    RN487X_EVENT_STREAM_OPEN    = 2,    /**< %STREAM_OPEN% - transparent UART ready */
+    RN487X_EVENT_CONN_PARAM     = 3,    /**< %CONN_PARAM,<interval>,<latency>,<timeout>% - connection.param is valid */
+    RN487X_EVENT_REBOOT         = 4,    /**< %REBOOT% */
+    RN487X_EVENT_CONN_PARAM_REJECTED = 5,   /**< %ERR_CONNPARAM% - the peer refused RN487X_SetConnParamsAsync() */
+    RN487X_EVENT_CHAR_WRITE     = 6     /**< %WV,<handle>,<value>% - connection.write is valid */
+}RN487X_EVENT_TYPE_t;
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * Struct of an RN487X Event, with the parameters parsed from the status message
+ */
+typedef struct
+{
+    RN487X_EVENT_TYPE_t type;
+    union
+    {
+        struct
+        {
+            uint8_t addressType;                    /**< 0 - public | 1 - random address */
+            uint8_t address[RN487X_ADDRESS_SIZE];   /**< Peer address, most significant byte first */
+        }connect;
+        struct
+        {
+            uint16_t interval;                      /**< Connection interval, in 1.25 ms units */
+            uint16_t latency;                       /**< Peripheral latency, in connection events */
+            uint16_t timeout;                       /**< Supervision timeout, in 10 ms units */
+        }param;
+        struct
+        {
+            uint16_t handle;                        /**< Handle of the server characteristic written by the client */
+            uint8_t length;                         /**< Value length */
+            const uint8_t *value;                   /**< Value bytes, valid during the handler call */
+        }write;
+    }connection;
+}rn487x_event_t;
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * Prototype of an RN487X Event handler
+ */
+typedef void (*rn487x_event_handler_t)(const rn487x_event_t *event);
+
 /**
  * \ingroup RN487X_INTERFACE
  * Struct of RN487X Interface Function Pointer Prototypes
@@ -49,8 +168,15 @@ typedef struct
     // RN487x UART interface control
     void (*Write)(uint8_t);
     uint8_t (*Read)(void);
+    bool (*ReadTimeout)(uint8_t*, uint16_t);
     bool (*TransmitDone)(void);
     bool (*DataReady)(void);
+    void (*WriteBlock)(const uint8_t*, uint8_t);
+    uint8_t (*ReadBlock)(uint8_t*, uint8_t);
+    uint8_t (*TryWriteBlock)(const uint8_t*, uint8_t);
+    uint8_t (*TxSpace)(void);
+    void (*SetTxDrainedHandler)(void (*)(void));
+    bool (*SetBaudRate)(RN487X_BAUD_RATES_t);
     // RN487x RX_IND pin control
     void (*IndicateRx)(bool);
     // RN487x Reset pin control
@@ -60,7 +186,7 @@ typedef struct
     // Delay API
     void (*DelayMs)(uint16_t);
     // Status Message Handler
-    void (*AsyncHandler)(char*);
+    void (*AsyncHandler)(RN487X_STATUS_t, char*);
 }iRN487X_FunctionPtrs_t;
 
 extern const iRN487X_FunctionPtrs_t RN487X;
@@ -74,4 +200,29 @@ extern const iRN487X_FunctionPtrs_t RN487X;
  */
 bool RN487X_IsConnected(void);
 
+/**
+ * \ingroup RN487X_INTERFACE
+ * \brief Subscribes a handler to the RN487X Events
+ * 
+ * The handler is called, from the context reading the RN487X data, for every
+ * CONNECT, DISCONNECT, STREAM_OPEN, CONN_PARAM, REBOOT, ERR_CONNPARAM and WV
+ * status message.
+ * \param handler Event handler
+ * \return Subscription Status
+ * \retval true - Subscribed.
+ * \retval false - RN487X_EVENT_SUBSCRIBERS_MAX handlers already subscribed
+ */
+bool RN487X_SubscribeEvents(rn487x_event_handler_t handler);
+
+/**
+ * \ingroup RN487X_INTERFACE
+ * \brief Converts a hex ASCII character received from the RN487X to its value
+ * 
+ * Both lower and upper case digits are accepted, see NIBBLE2ASCII() for the
+ * reverse conversion.
+ * \param ascii Hex character
+ * \return Nibble value
+ */
+uint8_t RN487X_AsciiToNibble(uint8_t ascii);
+
 #endif	/* RN487X_INTERFACE_H */
\ No newline at end of file
@@ -129,6 +129,18 @@ bool TMR0_HasOverflowOccured(void)
     // check if  overflow has occurred by checking the TMRIF bit
     return(PIR0bits.TMR0IF);
 }
+
+uint16_t TMR0_ReadTimestamp(void)
+{
+    uint16_t readVal;
+    bool state = INTCONbits.GIE;
+
+    INTCONbits.GIE = 0;
+    readVal = TMR0_ReadTimer();
+    INTCONbits.GIE = state;
+
+    return readVal;
+}
 /**
   End of File
 */
\ No newline at end of file
@@ -53,6 +53,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "device_config.h"
 
 #ifdef __cplusplus  // Provide C++ Compatibility
 
@@ -62,6 +63,29 @@
 
 
 
+/**
+  Section: Macro Declarations
+*/
+
+/**
+  @Summary
+    TMR0 clock prescaler
+
+  @Description
+    Number of FOSC/4 clocks per TMR0 count, as selected by T0CKPS in
+    TMR0_Initialize().
+*/
+#define TMR0_PRESCALER 128UL
+
+/**
+  @Summary
+    TMR0 count frequency, in Hz
+
+  @Description
+    Used to convert TMR0 counts read with TMR0_ReadTimestamp() into time.
+*/
+#define TMR0_TICK_FREQUENCY ((_XTAL_FREQ) / 4UL / TMR0_PRESCALER)
+
 /**
   Section: TMR0 APIs
 */
@@ -309,6 +333,28 @@ void TMR0_Reload(void);
 */
 bool TMR0_HasOverflowOccured(void);
 
+/**
+  @Summary
+    Reads the TMR0 register outside of the interrupts.
+
+  @Description
+    This function reads the 16-bit TMR0 value like TMR0_ReadTimer(), with the
+    interrupts disabled. Interrupt handlers reading TMR0 would otherwise
+    replace the high byte latched by the low byte read.
+    While TMR0 is left free running, the difference of two readings measures
+    intervals of up to 65535 counts of TMR0_TICK_FREQUENCY.
+
+  @Preconditions
+    Initialize  the TMR0 before calling this function.
+
+  @Param
+    None
+
+  @Returns
+    Current TMR0 value
+*/
+uint16_t TMR0_ReadTimestamp(void);
+
 #ifdef __cplusplus  // Provide C++ Compatibility
 
     }